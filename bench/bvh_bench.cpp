@@ -0,0 +1,147 @@
+// Builds a MeshBvh over a synthetic triangle soup and times building,
+// refitting, picking and culling against a brute force scan
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include "bvh.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+auto seconds(const std::function<void()>& fn) -> double {
+    const auto start = Clock::now();
+    fn();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Small triangles jittered around the cells of a square grid
+auto makeSoup(size_t count, std::mt19937& rng) -> std::vector<Triangle> {
+    const auto side = static_cast<size_t>(std::ceil(std::sqrt(count)));
+    std::uniform_real_distribution<float> jitter(-0.5f, 1.5f);
+    std::vector<Triangle> triangles(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto x = static_cast<float>(i % side);
+        const auto y = static_cast<float>(i / side);
+        triangles[i] = Triangle{{x + jitter(rng), y + jitter(rng)},
+                                {x + jitter(rng), y + jitter(rng)},
+                                {x + jitter(rng), y + jitter(rng)}};
+    }
+    return triangles;
+}
+
+auto bruteForcePick(const std::vector<Triangle>& triangles, const Vec2& p)
+    -> std::optional<uint32_t> {
+    for (size_t i = triangles.size(); i-- > 0;) {
+        if (triangles[i].contains(p)) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    const size_t count =
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t{2'000'000};
+    const size_t queries =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : size_t{100'000};
+
+    try {
+        std::mt19937 rng(42);
+        const std::vector<Triangle> soup = makeSoup(count, rng);
+        const auto side = static_cast<float>(std::ceil(std::sqrt(count)));
+        fmt::println("triangles: {}, queries: {}", count, queries);
+
+        MeshBvh mesh;
+        const unsigned hardwareThreads =
+            std::max(1U, std::thread::hardware_concurrency());
+        for (const unsigned threads : {1U, hardwareThreads}) {
+            const double t = seconds([&] { mesh.build(soup, threads); });
+            fmt::println("build ({} thr): {:.1f} ms", threads, t * 1e3);
+            if (hardwareThreads == 1) {
+                break;
+            }
+        }
+        fmt::println("nodes: {} ({} KiB)", mesh.bvh().nodes().size(),
+                     mesh.bvh().nodes().size() * sizeof(BvhNode) / 1024);
+
+        std::uniform_real_distribution<float> coord(0.0f, side);
+        std::vector<Vec2> points(queries);
+        for (Vec2& p : points) {
+            p = {coord(rng), coord(rng)};
+        }
+
+        size_t hits = 0;
+        const double pickTime = seconds([&] {
+            for (const Vec2& p : points) {
+                hits += mesh.pick(p).has_value();
+            }
+        });
+        fmt::println("pick: {:.3f} us/query, {} hits",
+                     pickTime / queries * 1e6, hits);
+
+        const size_t checked = std::min<size_t>(queries, 20);
+        size_t mismatches = 0;
+        const double bruteTime = seconds([&] {
+            for (size_t i = 0; i < checked; ++i) {
+                mismatches += bruteForcePick(mesh.triangles(), points[i]) !=
+                              mesh.pick(points[i]);
+            }
+        });
+        fmt::println("brute force pick: {:.3f} us/query, {} mismatches",
+                     bruteTime / checked * 1e6, mismatches);
+
+        const float extent = side * 0.1f;
+        const Aabb view{{side * 0.45f, side * 0.45f},
+                        {side * 0.45f + extent, side * 0.45f + extent}};
+        size_t visible = 0;
+        const double cullTime =
+            seconds([&] { visible = mesh.cull(view).size(); });
+        fmt::println("cull 1% view: {:.3f} ms, {} visible", cullTime * 1e3,
+                     visible);
+
+        // drift every vertex, as an animated instance would
+        Data animated;
+        for (const Triangle& tri : mesh.triangles()) {
+            for (const Vec2& v : {tri.a, tri.b, tri.c}) {
+                animated.vertex.insert(animated.vertex.end(),
+                                       {v.x + 0.25f, v.y, 0.0f, 0.0f, 0.0f});
+            }
+        }
+        const size_t vertexCount =
+            std::min<size_t>(animated.vertex.size() / kComponentsPerVertex,
+                             std::numeric_limits<uint16_t>::max());
+        animated.vertex.resize(vertexCount * kComponentsPerVertex);
+        for (size_t i = 0; i + 2 < vertexCount; i += 3) {
+            animated.index.insert(animated.index.end(),
+                                  {static_cast<uint16_t>(i),
+                                   static_cast<uint16_t>(i + 1),
+                                   static_cast<uint16_t>(i + 2)});
+        }
+        MeshBvh small;
+        small.build(animated);
+        for (size_t i = 0; i < animated.vertex.size();
+             i += kComponentsPerVertex) {
+            animated.vertex[i] += 0.5f;
+        }
+        const double refitTime = seconds([&] { small.refit(animated); });
+        const double rebuildTime = seconds([&] { small.build(animated); });
+        fmt::println("{} triangles: refit {:.3f} ms, rebuild {:.3f} ms",
+                     animated.index.size() / 3, refitTime * 1e3,
+                     rebuildTime * 1e3);
+    } catch (const std::exception& e) {
+        fmt::println(stderr, "Benchmark failed: {}", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,519 @@
+// Headless micro-benchmarks for the Dawn paths App relies on: buffer uploads,
+// buffer to buffer copies, submit overhead and compute dispatch latency.
+// Results are written as CSV or JSON so runs can be compared between commits.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include "debug.hpp"
+#include "gpu_bootstrap.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    bool forceFallbackAdapter = true;
+    bool json = false;
+    std::string output;  // stdout when empty
+    std::string label;
+    int iterations = 20;
+    uint64_t minSize = 4 * 1024;
+    uint64_t maxSize = 64 * 1024 * 1024;
+    std::vector<uint32_t> batches{1, 4, 16, 64};
+};
+
+struct Result {
+    std::string benchmark;
+    uint64_t bytes;
+    uint32_t batch;
+    double meanMicros;  // per iteration
+    double gbPerSecond;  // 0 when nothing moved or too fast to time
+
+    // Per command buffer, copy or dispatch in the batch
+    auto itemMicros() const -> double { return meanMicros / batch; }
+};
+
+auto parseArgs(int argc, char* argv[]) -> Options {
+    Options options;
+    auto value = [&](int& i) -> std::string {
+        if (i + 1 >= argc) {
+            throw std::runtime_error(
+                fmt::format("Missing value for {}", argv[i]));
+        }
+        return argv[++i];
+    };
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--hardware") {
+            options.forceFallbackAdapter = false;
+        } else if (arg == "--format") {
+            const std::string format = value(i);
+            if (format != "csv" && format != "json") {
+                throw std::runtime_error(
+                    fmt::format("Unknown format {}", format));
+            }
+            options.json = format == "json";
+        } else if (arg == "--output") {
+            options.output = value(i);
+        } else if (arg == "--label") {
+            options.label = value(i);
+        } else if (arg == "--iterations") {
+            options.iterations = std::max(1, std::stoi(value(i)));
+        } else if (arg == "--min-size") {
+            options.minSize = std::max<uint64_t>(4, std::stoull(value(i)));
+            options.minSize = (options.minSize + 3) & ~uint64_t{3};
+        } else if (arg == "--max-size") {
+            options.maxSize = std::stoull(value(i));
+        } else {
+            throw std::runtime_error(fmt::format(
+                "Unknown argument {}\nUsage: {} [--hardware] [--format "
+                "csv|json] [--output file] [--label text] [--iterations n] "
+                "[--min-size bytes] [--max-size bytes]",
+                arg, argv[0]));
+        }
+    }
+    return options;
+}
+
+auto escapeJson(const std::string& text) -> std::string {
+    std::string out;
+    for (const char c : text) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += fmt::format("\\u{:04x}",
+                                       static_cast<unsigned char>(c));
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// RFC 4180 field, so commas and quotes in labels don't shift the columns
+auto quoteCsv(const std::string& text) -> std::string {
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    return out + '"';
+}
+
+class GpuBench {
+   public:
+    explicit GpuBench(const Options& options) : options(options) {
+        instance = gpu_bootstrap::createInstance();
+        adapter = gpu_bootstrap::requestAdapter(instance, nullptr,
+                                                options.forceFallbackAdapter);
+
+        // the defaults cap buffers at 256 MiB, ask for what the adapter has
+        wgpu::SupportedLimits supported;
+        adapter.GetLimits(&supported);
+        wgpu::RequiredLimits required{
+            .limits{
+                .maxStorageBufferBindingSize =
+                    supported.limits.maxStorageBufferBindingSize,
+                .maxBufferSize = supported.limits.maxBufferSize,
+            },
+        };
+        maxSize = std::min(options.maxSize, supported.limits.maxBufferSize);
+        if (maxSize < options.maxSize) {
+            std::cerr << fmt::format(
+                "--max-size {} exceeds the adapter maxBufferSize, using {}\n",
+                options.maxSize, maxSize);
+        }
+
+        device = gpu_bootstrap::requestDevice(instance, adapter, &required);
+        queue = device.GetQueue();
+        if (!queue) {
+            throw std::runtime_error("Failed to create queue. Check logs");
+        }
+        wgpu::AdapterInfo info;
+        adapter.GetInfo(&info);
+        adapterName = info.device ? info.device : "unknown";
+    }
+
+    void run() {
+        for (uint64_t size = options.minSize; size <= maxSize; size *= 4) {
+            validated("write_buffer", [&] { writeBufferUpload(size); });
+            validated("mapped_at_creation",
+                      [&] { mappedAtCreationUpload(size); });
+            validated("map_async_staging", [&] { mapAsyncUpload(size); });
+            for (const uint32_t batch : options.batches) {
+                validated("copy_buffer_to_buffer",
+                          [&] { copyThroughput(size, batch); });
+            }
+        }
+        for (const uint32_t batch : options.batches) {
+            validated("submit_batched", [&] { submitOverhead(batch, true); });
+            validated("submit_individual",
+                      [&] { submitOverhead(batch, false); });
+            validated("compute_dispatch", [&] { dispatchLatency(batch); });
+        }
+    }
+
+    void write(std::ostream& out) const {
+        if (options.json) {
+            out << fmt::format(
+                "{{\"label\":\"{}\",\"adapter\":\"{}\",\"fallback\":{},"
+                "\"iterations\":{},\"results\":[\n",
+                escapeJson(options.label), escapeJson(adapterName),
+                options.forceFallbackAdapter, options.iterations);
+            for (size_t i = 0; i < results.size(); ++i) {
+                const Result& r = results[i];
+                out << fmt::format(
+                    "  {{\"benchmark\":\"{}\",\"bytes\":{},\"batch\":{},"
+                    "\"mean_us\":{:.3f},\"item_us\":{:.3f},"
+                    "\"gb_per_s\":{:.4f}}}{}\n",
+                    r.benchmark, r.bytes, r.batch, r.meanMicros,
+                    r.itemMicros(), r.gbPerSecond,
+                    i + 1 < results.size() ? "," : "");
+            }
+            out << "]}\n";
+            return;
+        }
+        out << "label,adapter,benchmark,bytes,batch,iterations,mean_us,"
+               "item_us,gb_per_s\n";
+        for (const Result& r : results) {
+            out << fmt::format("{},{},{},{},{},{},{:.3f},{:.3f},{:.4f}\n",
+                               quoteCsv(options.label), quoteCsv(adapterName),
+                               r.benchmark, r.bytes, r.batch,
+                               options.iterations,
+                               r.meanMicros, r.itemMicros(), r.gbPerSecond);
+        }
+    }
+
+   private:
+    const Options& options;
+    wgpu::Instance instance;
+    wgpu::Adapter adapter;
+    wgpu::Device device;
+    wgpu::Queue queue;
+    std::string adapterName;
+    uint64_t maxSize;  // options.maxSize clamped to the device limit
+    std::vector<Result> results;
+
+    // Runs one case inside a validation error scope, so a case that fails
+    // validation aborts the run instead of being recorded as a result
+    template <typename Case>
+    void validated(const char* benchmark, Case&& benchCase) {
+        const size_t recorded = results.size();
+        device.PushErrorScope(wgpu::ErrorFilter::Validation);
+        benchCase();
+
+        struct Scope {
+            bool ok = false;
+            std::string message;
+        };
+        auto callback = [](wgpu::PopErrorScopeStatus status,
+                           wgpu::ErrorType type, const char* message,
+                           Scope* scope) {
+            scope->ok = status == wgpu::PopErrorScopeStatus::Success &&
+                        type == wgpu::ErrorType::NoError;
+            scope->message = message ? message : "";
+        };
+        Scope scope;
+        wgpu::Future future = device.PopErrorScope(
+            wgpu::CallbackMode::WaitAnyOnly, callback, &scope);
+        instance.WaitAny(future, UINT64_MAX);
+        if (!scope.ok) {
+            results.resize(recorded);
+            throw std::runtime_error(fmt::format(
+                "{} failed validation: {}", benchmark, scope.message));
+        }
+    }
+
+    // Blocks until the GPU has finished all submitted work
+    void waitIdle() {
+        auto callback = [](wgpu::QueueWorkDoneStatus status, bool* ok) {
+            *ok = status == wgpu::QueueWorkDoneStatus::Success;
+        };
+        bool ok = false;
+        wgpu::Future future = queue.OnSubmittedWorkDone(
+            wgpu::CallbackMode::WaitAnyOnly, callback, &ok);
+        instance.WaitAny(future, UINT64_MAX);
+        if (!ok) {
+            throw std::runtime_error("Queue failed to finish submitted work");
+        }
+    }
+
+    void mapForWrite(const wgpu::Buffer& buffer, uint64_t size) {
+        auto callback = [](wgpu::MapAsyncStatus status, const char* message,
+                           bool* ok) {
+            *ok = status == wgpu::MapAsyncStatus::Success;
+            if (!*ok) {
+                debug_callbacks::onMapAsync(status, message);
+            }
+        };
+        bool ok = false;
+        wgpu::Future future =
+            buffer.MapAsync(wgpu::MapMode::Write, 0, size,
+                            wgpu::CallbackMode::WaitAnyOnly, callback, &ok);
+        instance.WaitAny(future, UINT64_MAX);
+        if (!ok) {
+            throw std::runtime_error("Failed to map staging buffer");
+        }
+    }
+
+    auto createBuffer(const char* label,
+                      wgpu::BufferUsage usage,
+                      uint64_t size,
+                      bool mappedAtCreation = false) -> wgpu::Buffer {
+        wgpu::BufferDescriptor desc{
+            .label = label,
+            .usage = usage,
+            .size = size,
+            .mappedAtCreation = mappedAtCreation,
+        };
+        return device.CreateBuffer(&desc);
+    }
+
+    void submit(const wgpu::CommandEncoder& encoder) {
+        const wgpu::CommandBuffer buf = encoder.Finish();
+        queue.Submit(1, &buf);
+    }
+
+    // Times body() per iteration after one untimed warm-up, and records the
+    // result with bytes moved per iteration. prepare() and finish() run
+    // before and after each body() outside the timed region
+    template <typename Prepare, typename Body, typename Finish>
+    void measure(const char* benchmark,
+                 uint64_t bytes,
+                 uint32_t batch,
+                 Prepare&& prepare,
+                 Body&& body,
+                 Finish&& finish) {
+        double seconds = 0.0;
+        for (int i = -1; i < options.iterations; ++i) {  // -1 is the warm-up
+            prepare();
+            const auto start = Clock::now();
+            body();
+            const std::chrono::duration<double> elapsed = Clock::now() - start;
+            finish();
+            if (i >= 0) {
+                seconds += elapsed.count();
+            }
+        }
+        seconds /= options.iterations;
+        results.push_back(Result{
+            .benchmark = benchmark,
+            .bytes = bytes,
+            .batch = batch,
+            .meanMicros = seconds * 1e6,
+            .gbPerSecond =
+                bytes > 0 && seconds > 0.0 ? bytes / seconds * 1e-9 : 0.0,
+        });
+        std::cerr << fmt::format("{:<24} {:>10} B x{:<3} {:12.3f} us\n",
+                                 benchmark, bytes, batch, seconds * 1e6);
+    }
+
+    template <typename Body>
+    void measure(const char* benchmark,
+                 uint64_t bytes,
+                 uint32_t batch,
+                 Body&& body) {
+        measure(benchmark, bytes, batch, [] {}, body, [] {});
+    }
+
+    void writeBufferUpload(uint64_t size) {
+        const std::vector<uint8_t> host(size, 0xAB);
+        wgpu::Buffer dst = createBuffer(
+            "WriteBuffer dst",
+            wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage, size);
+        measure("write_buffer", size, 1, [&] {
+            queue.WriteBuffer(dst, 0, host.data(), size);
+            waitIdle();
+        });
+    }
+
+    void mappedAtCreationUpload(uint64_t size) {
+        const std::vector<uint8_t> host(size, 0xAB);
+        wgpu::Buffer dst = createBuffer(
+            "MappedAtCreation dst",
+            wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage, size);
+        measure("mapped_at_creation", size, 1, [&] {
+            wgpu::Buffer staging = createBuffer(
+                "MappedAtCreation staging", wgpu::BufferUsage::CopySrc, size,
+                true);
+            std::memcpy(staging.GetMappedRange(0, size), host.data(), size);
+            staging.Unmap();
+            wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+            encoder.CopyBufferToBuffer(staging, 0, dst, 0, size);
+            submit(encoder);
+            waitIdle();
+            staging.Destroy();
+        });
+    }
+
+    void mapAsyncUpload(uint64_t size) {
+        const std::vector<uint8_t> host(size, 0xAB);
+        wgpu::Buffer dst = createBuffer(
+            "MapAsync dst",
+            wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage, size);
+        wgpu::Buffer staging = createBuffer(
+            "MapAsync staging",
+            wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc, size);
+        measure("map_async_staging", size, 1, [&] {
+            mapForWrite(staging, size);
+            std::memcpy(staging.GetMappedRange(0, size), host.data(), size);
+            staging.Unmap();
+            wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+            encoder.CopyBufferToBuffer(staging, 0, dst, 0, size);
+            submit(encoder);
+            waitIdle();
+        });
+    }
+
+    void copyThroughput(uint64_t size, uint32_t batch) {
+        wgpu::Buffer src = createBuffer(
+            "Copy src", wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst,
+            size);
+        wgpu::Buffer dst = createBuffer(
+            "Copy dst", wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst,
+            size);
+        measure("copy_buffer_to_buffer", size * batch, batch, [&] {
+            wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+            for (uint32_t i = 0; i < batch; ++i) {
+                encoder.CopyBufferToBuffer(src, 0, dst, 0, size);
+            }
+            submit(encoder);
+            waitIdle();
+        });
+    }
+
+    // Empty command buffers, encoded beforehand and waited on afterwards, so
+    // only the Submit calls themselves are timed
+    void submitOverhead(uint32_t batch, bool batched) {
+        std::vector<wgpu::CommandBuffer> buffers(batch);
+        const auto encode = [&] {
+            for (wgpu::CommandBuffer& buf : buffers) {
+                buf = device.CreateCommandEncoder().Finish();
+            }
+        };
+        const auto submitAll = [&] {
+            if (batched) {
+                queue.Submit(buffers.size(), buffers.data());
+            } else {
+                for (const wgpu::CommandBuffer& buf : buffers) {
+                    queue.Submit(1, &buf);
+                }
+            }
+        };
+        measure(batched ? "submit_batched" : "submit_individual", 0, batch,
+                encode, submitAll, [&] { waitIdle(); });
+    }
+
+    auto loadComputeShader() -> wgpu::ShaderModule {
+        std::string tmp, shaderSource;
+        std::ifstream file(RESOURCE_DIR "/bench_compute.wgsl");
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open bench_compute.wgsl");
+        }
+        while (std::getline(file, tmp)) {
+            shaderSource += tmp + "\n";
+        }
+        wgpu::ShaderModuleWGSLDescriptor wgsl_desc({
+            .code = shaderSource.c_str(),
+        });
+        wgpu::ShaderModuleDescriptor sm_desc{
+            .nextInChain = &wgsl_desc,
+        };
+        return device.CreateShaderModule(&sm_desc);
+    }
+
+    // One single-workgroup dispatch per batch entry, waited on as a whole, so
+    // batch 1 measures the round trip latency of a dispatch
+    void dispatchLatency(uint32_t batch) {
+        constexpr uint64_t kSize = 64 * sizeof(uint32_t);
+        wgpu::ComputePipelineDescriptor desc{
+            .layout = nullptr,
+            .compute{
+                .module = loadComputeShader(),
+                .entryPoint = "main",
+            },
+        };
+        wgpu::ComputePipeline pipeline = device.CreateComputePipeline(&desc);
+        wgpu::Buffer storage = createBuffer(
+            "Dispatch storage",
+            wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst, kSize);
+        wgpu::BindGroupEntry bge{
+            .binding = 0,
+            .buffer = storage,
+            .offset = 0,
+            .size = kSize,
+        };
+        wgpu::BindGroupDescriptor bg_desc{
+            .layout = pipeline.GetBindGroupLayout(0),
+            .entryCount = 1,
+            .entries = &bge,
+        };
+        wgpu::BindGroup bindGroup = device.CreateBindGroup(&bg_desc);
+
+        measure("compute_dispatch", 0, batch, [&] {
+            wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+            wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+            pass.SetPipeline(pipeline);
+            pass.SetBindGroup(0, bindGroup);
+            for (uint32_t i = 0; i < batch; ++i) {
+                pass.DispatchWorkgroups(1);
+            }
+            pass.End();
+            submit(encoder);
+            waitIdle();
+        });
+    }
+};
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    try {
+        const Options options = parseArgs(argc, argv);
+        GpuBench bench(options);
+        bench.run();
+        if (options.output.empty()) {
+            bench.write(std::cout);
+        } else {
+            std::ofstream file(options.output);
+            if (!file.is_open()) {
+                throw std::runtime_error(
+                    fmt::format("Failed to open file {}", options.output));
+            }
+            bench.write(file);
+        }
+    } catch (const std::exception& e) {
+        fmt::println(stderr, "Benchmark failed: {}", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+// Compares the text loader against the compressed mesh format: reports the
+// compression ratio of the input and a synthetic mesh, and decode throughput
+// on the synthetic one
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include "loader.hpp"
+#include "mesh_codec.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kGridSide = 256;  // 65536 vertices, the uint16 index limit
+
+// Non-repeating mesh: a grid with jittered positions and noisy colours, so
+// the ratio reflects the encoding rather than LZ4 finding repeated copies
+auto jitteredGrid() -> Data {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> jitter(-0.4f, 0.4f);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    const float step = 2.0f / (kGridSide - 1);
+
+    Data grid;
+    for (size_t y = 0; y < kGridSide; ++y) {
+        for (size_t x = 0; x < kGridSide; ++x) {
+            const float u = static_cast<float>(x) / (kGridSide - 1);
+            const float v = static_cast<float>(y) / (kGridSide - 1);
+            grid.vertex.insert(
+                grid.vertex.end(),
+                {-1.0f + (static_cast<float>(x) + jitter(rng)) * step,
+                 -1.0f + (static_cast<float>(y) + jitter(rng)) * step,
+                 std::clamp(u + noise(rng), 0.0f, 1.0f),
+                 std::clamp(v + noise(rng), 0.0f, 1.0f),
+                 std::clamp(1.0f - u + noise(rng), 0.0f, 1.0f)});
+        }
+    }
+    for (size_t y = 0; y + 1 < kGridSide; ++y) {
+        for (size_t x = 0; x + 1 < kGridSide; ++x) {
+            const auto i = static_cast<uint16_t>(y * kGridSide + x);
+            const auto right = static_cast<uint16_t>(i + 1);
+            const auto up = static_cast<uint16_t>(i + kGridSide);
+            const auto diagonal = static_cast<uint16_t>(up + 1);
+            grid.index.insert(grid.index.end(),
+                              {i, right, diagonal, i, diagonal, up});
+        }
+    }
+    return grid;
+}
+
+void writeText(const fs::path& path, const Data& data) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error(
+            fmt::format("Failed to open file {}", path.c_str()));
+    }
+    file << "[points]\n";
+    for (size_t i = 0; i < data.vertex.size();
+         i += kComponentsPerVertex) {
+        file << fmt::format("{} {} {} {} {}\n", data.vertex[i],
+                            data.vertex[i + 1], data.vertex[i + 2],
+                            data.vertex[i + 3], data.vertex[i + 4]);
+    }
+    file << "\n[indices]\n";
+    for (size_t i = 0; i + 2 < data.index.size(); i += 3) {
+        file << fmt::format("{} {} {}\n", data.index[i], data.index[i + 1],
+                            data.index[i + 2]);
+    }
+}
+
+// Mean seconds per call, after one untimed warm-up
+auto measure(int iterations, const std::function<void()>& fn) -> double {
+    fn();
+    const auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+auto rawSize(const Data& data) -> size_t {
+    return data.vertex.size() * sizeof(float) +
+           data.index.size() * sizeof(uint16_t);
+}
+
+// textBytes is the size of the mesh in the text format the loader reads
+void reportRatio(const char* name, const Data& mesh, size_t textBytes) {
+    const size_t packedBytes = mesh_codec::encode(mesh).size();
+    fmt::println(
+        "{}: {} vertices, {} indices, text {} B, raw {} B, packed {} B "
+        "({:.2f}x vs text, {:.2f}x vs raw)",
+        name, mesh.vertex.size() / kComponentsPerVertex,
+        mesh.index.size(), textBytes, rawSize(mesh), packedBytes,
+        static_cast<double>(textBytes) / packedBytes,
+        static_cast<double>(rawSize(mesh)) / packedBytes);
+}
+
+auto maxError(const Data& expected, const Data& actual) -> float {
+    float error = 0.0f;
+    for (size_t i = 0; i < expected.vertex.size(); ++i) {
+        error = std::max(error, std::abs(expected.vertex[i] - actual.vertex[i]));
+    }
+    return error;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    const fs::path source = argc > 1 ? argv[1] : RESOURCE_DIR "/data.txt";
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    try {
+        const fs::path dir = fs::temp_directory_path();
+        const fs::path textPath = dir / "mesh_codec_bench.txt";
+        const fs::path packedPath =
+            dir / (std::string("mesh_codec_bench") + mesh_codec::kFileExtension);
+
+        Data input;
+        input.load(source);
+        reportRatio("input mesh", input, fs::file_size(source));
+
+        // the grid is also used for throughput, being large enough to time
+        const Data mesh = jitteredGrid();
+        writeText(textPath, mesh);
+        reportRatio("jittered grid", mesh, fs::file_size(textPath));
+        const std::vector<std::byte> blob = mesh_codec::encode(mesh);
+        mesh_codec::writeFile(packedPath, blob);
+        const size_t rawBytes = rawSize(mesh);
+
+        Data decoded;
+        const auto report = [&](const char* name, double seconds) {
+            fmt::println("{:<28} {:9.3f} ms {:8.3f} GB/s", name,
+                         seconds * 1e3, rawBytes / seconds * 1e-9);
+        };
+
+        report("text loader (file)", measure(iterations, [&] {
+                   decoded.load(textPath);
+               }));
+        report("packed loader (file)", measure(iterations, [&] {
+                   decoded.load(packedPath);
+               }));
+
+        const unsigned hardwareThreads =
+            std::max(1U, std::thread::hardware_concurrency());
+        for (const unsigned threads : {1U, hardwareThreads}) {
+            const std::string name =
+                fmt::format("decode in memory ({} thr)", threads);
+            report(name.c_str(), measure(iterations, [&] {
+                       mesh_codec::decode(blob, decoded, threads);
+                   }));
+            if (hardwareThreads == 1) {
+                break;
+            }
+        }
+
+        fmt::println("max quantization error: {}", maxError(mesh, decoded));
+        fmt::println("indices round-trip: {}",
+                     mesh.index == decoded.index ? "exact" : "MISMATCH");
+
+        fs::remove(textPath);
+        fs::remove(packedPath);
+    } catch (const std::exception& e) {
+        fmt::println(stderr, "Benchmark failed: {}", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
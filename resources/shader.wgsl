@@ -8,14 +8,19 @@ struct VertexOutput {
     @location(0) color: vec3f
 };
 
-@group(0) @binding(0) var<uniform> uTime: f32;
+// Mirrors Uniforms in app.hpp
+struct Uniforms {
+    time: f32,
+    ratio: f32,
+    offset: vec2f
+};
+
+@group(0) @binding(0) var<uniform> u: Uniforms;
 
 @vertex
 fn vs_main(in: VertexInput) -> VertexOutput {
-    let ratio = 800.0 / 600.0;
-    var offset = vec2f(-0.6874, -0.463);
-    offset += vec2f(cos(uTime), sin(uTime));
-    let pos = vec4f(in.position.x + offset.x, in.position.y * ratio + offset.y, 0.0, 1.0);
+    let offset = u.offset + vec2f(cos(u.time), sin(u.time));
+    let pos = vec4f(in.position.x + offset.x, in.position.y * u.ratio + offset.y, 0.0, 1.0);
     return VertexOutput(pos, in.color);
 }
 
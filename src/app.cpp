@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <climits>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <gsl/util>
@@ -22,6 +24,15 @@
 #include <webgpu/webgpu_cpp.h>
 
 #include "debug.hpp"
+#include "gpu_bootstrap.hpp"
+#include "metrics.hpp"
+
+namespace {
+// Retry delays when the surface has no texture to hand out, e.g. while the
+// window is minimised, in seconds
+constexpr double kMinAcquireBackoff = 0.001;
+constexpr double kMaxAcquireBackoff = 0.25;
+}  // namespace
 
 void App::createSurface() {
     WGPUSurface m_surface = glfwGetWGPUSurface(instance.Get(), window.get());
@@ -62,7 +73,11 @@ void App::initGLFW() {
 
 App::App(const wgpu::Extent2D& dims)
     : onDestroy(&glfwTerminate), dimensions(dims) {
-    data.load(RESOURCE_DIR "/data.txt");
+    {
+        metrics::ScopedTimer loadTimer(metrics::Histogram::LoadSeconds);
+        data.load(RESOURCE_DIR "/data.txt");
+    }
+    meshBvh.build(data);
     initGLFW();
     initWebGPU();
     configureSurface();
@@ -76,6 +91,8 @@ App::~App() noexcept {
 
 void App::render(const wgpu::TextureView& targetView) {
     {
+        // encode and submit only, Present() may block on vsync
+        metrics::ScopedTimer renderTimer(metrics::Histogram::RenderCpuSeconds);
         wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
         {
             wgpu::RenderPassColorAttachment attachment[1]{
@@ -102,6 +119,8 @@ void App::render(const wgpu::TextureView& targetView) {
                                              wgpu::IndexFormat::Uint16);
             renderPassEncoder.SetBindGroup(0, bindGroup);
             renderPassEncoder.DrawIndexed(data.index.size(), 1, 0, 0, 0);
+            metrics::add(metrics::Counter::DrawCalls);
+            metrics::add(metrics::Counter::Triangles, data.index.size() / 3);
             renderPassEncoder.End();
         }
         {
@@ -117,58 +136,153 @@ void App::render(const wgpu::TextureView& targetView) {
     device.Tick();
 }
 
+void App::writeBuffer(const wgpu::Buffer& buffer,
+                      uint64_t offset,
+                      const void* data,
+                      size_t size) {
+    queue.WriteBuffer(buffer, offset, data, size);
+    metrics::add(metrics::Counter::WriteBufferCalls);
+    metrics::add(metrics::Counter::BytesUploaded, size);
+}
+
 void App::run() noexcept {
+    glfwSetWindowUserPointer(window.get(), this);
+    glfwSetKeyCallback(window.get(), &App::onKey);
+    glfwSetWindowRefreshCallback(window.get(), &App::onRefresh);
+    glfwSetMouseButtonCallback(window.get(), &App::onMouseButton);
+
+    double lastTime = glfwGetTime();
+    nextAnimationFrame = lastTime;
     while (!glfwWindowShouldClose(window.get())) {
-        glfwPollEvents();
+        waitForEvents();
+        const double now = glfwGetTime();
+        stats.onWakeup();
+        stats.maybeReport(now);
+        metricsExporter.maybeExport(now);
+
+        if (animating) {
+            animationTime += static_cast<float>(now - lastTime);
+            if (now >= nextAnimationFrame) {
+                needsRedraw = true;
+                nextAnimationFrame += animationInterval;
+                if (nextAnimationFrame < now) {
+                    // don't burst to catch up after a long stall
+                    nextAnimationFrame = now + animationInterval;
+                }
+            }
+        }
+        lastTime = now;
+        if (redrawMode == RedrawMode::Continuous) {
+            needsRedraw = true;
+        }
+        if (!needsRedraw) {
+            continue;
+        }
+
         wgpu::TextureView targetView = getNextTextureView();
-        if (!targetView)
+        if (!targetView) {
+            stats.onAcquireFailure();
+            acquireBackoff = std::clamp(acquireBackoff * 2.0,
+                                        kMinAcquireBackoff, kMaxAcquireBackoff);
             continue;
-        float t = static_cast<float>(glfwGetTime());
-        queue.WriteBuffer(uniformBuffer, 0, &t, sizeof(float));
+        }
+        acquireBackoff = 0.0;
+        needsRedraw = false;
+        uniforms.time = animationTime;
+        writeBuffer(uniformBuffer, offsetof(Uniforms, time), &uniforms.time,
+                    sizeof(uniforms.time));
         render(targetView);
+        stats.onFrame();
     }
+    metricsExporter.exportNow();
 }
 
-// ReSharper disable once CppMemberFunctionMayBeStatic
-// There's no point doing this outside of the constructor
-void App::createInstance() {  // NOLINT(*-convert-member-functions-to-static)
-    wgpu::InstanceDescriptor desc{
-        .features{
-            .timedWaitAnyEnable = true,
-        },
-    };
-    instance = wgpu::CreateInstance(&desc);
-    if (!instance) {
-        throw std::runtime_error("Failed to create webGPU instance.");
+void App::requestRedraw() {
+    needsRedraw = true;
+}
+
+void App::waitForEvents() {
+    if (acquireBackoff > 0.0) {
+        glfwWaitEventsTimeout(acquireBackoff);
+        return;
+    }
+    if (redrawMode == RedrawMode::Continuous || needsRedraw) {
+        glfwPollEvents();
+        return;
+    }
+    double deadline =
+        std::min(stats.nextReport(), metricsExporter.nextExport());
+    if (animating) {
+        deadline = std::min(deadline, nextAnimationFrame);
+    }
+    if (std::isinf(deadline)) {
+        glfwWaitEvents();
+        return;
+    }
+    const double remaining = deadline - glfwGetTime();
+    if (remaining > 0.0) {
+        glfwWaitEventsTimeout(remaining);
+    } else {
+        glfwPollEvents();
     }
 }
 
-void App::requestAdapter() {
-    wgpu::RequestAdapterOptions opts{
-        .compatibleSurface = surface,
-        .forceFallbackAdapter = false,
-    };
+void App::onKey(GLFWwindow* window,
+                int key,
+                int /*scancode*/,
+                int action,
+                int /*mods*/) {
+    auto* app = static_cast<App*>(glfwGetWindowUserPointer(window));
+    if (!app || action != GLFW_PRESS) {
+        return;
+    }
+    if (key == GLFW_KEY_SPACE) {
+        app->animating = !app->animating;
+    }
+    app->requestRedraw();
+}
 
-    // ReSharper disable once CppParameterMayBeConst
-    // ReSharper disable once CppPassValueParameterByConstReference
-    // The signature needs to match that requested by wgpu
-    auto callback = [](wgpu::RequestAdapterStatus status,
-                       wgpu::Adapter _adapter, const char* message,
-                       wgpu::Adapter* result) {
-        if (status != wgpu::RequestAdapterStatus::Success) {
-            std::cerr << "Failed to obtain adapter: " << std::endl;
-            return;
-        }
-        *result = std::move(_adapter);
-    };
+void App::onRefresh(GLFWwindow* window) {
+    if (auto* app = static_cast<App*>(glfwGetWindowUserPointer(window))) {
+        app->requestRedraw();
+    }
+}
 
-    wgpu::Future future = instance.RequestAdapter(
-        &opts, wgpu::CallbackMode::WaitAnyOnly, callback, &adapter);
-    instance.WaitAny(future, UINT64_MAX);
-    if (!adapter) {
-        throw std::runtime_error("Failed to create adapter. Check logs");
+void App::onMouseButton(GLFWwindow* window,
+                        int button,
+                        int action,
+                        int /*mods*/) {
+    auto* app = static_cast<App*>(glfwGetWindowUserPointer(window));
+    if (!app || button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) {
+        return;
+    }
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    const Vec2 point = app->cursorToMesh(x, y);
+    if (const auto triangle = app->meshBvh.pick(point)) {
+        fmt::println("Picked triangle {} at ({:.3f}, {:.3f})", *triangle,
+                     point.x, point.y);
+    } else {
+        fmt::println("Nothing under the cursor at ({:.3f}, {:.3f})", point.x,
+                     point.y);
     }
-};
+}
+
+auto App::cursorToMesh(double x, double y) const -> Vec2 {
+    const float offsetX = uniforms.offset[0] + std::cos(uniforms.time);
+    const float offsetY = uniforms.offset[1] + std::sin(uniforms.time);
+    const auto clipX = static_cast<float>(2.0 * x / dimensions.width - 1.0);
+    const auto clipY = static_cast<float>(1.0 - 2.0 * y / dimensions.height);
+    return {clipX - offsetX, (clipY - offsetY) / uniforms.aspectRatio};
+}
+
+void App::createInstance() {
+    instance = gpu_bootstrap::createInstance();
+}
+
+void App::requestAdapter() {
+    adapter = gpu_bootstrap::requestAdapter(instance, surface);
+}
 
 wgpu::RequiredLimits App::getRequiredLimits() {
     // wgpu::SupportedLimits supportedLimits;
@@ -181,7 +295,7 @@ wgpu::RequiredLimits App::getRequiredLimits() {
             .maxVertexBuffers = 1,
             .maxBufferSize = data.maxBufferSize(),
             .maxVertexAttributes = 2,
-            .maxVertexBufferArrayStride = 5 * sizeof(float),
+            .maxVertexBufferArrayStride = kComponentsPerVertex * sizeof(float),
             .maxInterStageShaderComponents = 3,
         },
     };
@@ -190,31 +304,7 @@ wgpu::RequiredLimits App::getRequiredLimits() {
 
 void App::requestDeviceAndQueue() {
     wgpu::RequiredLimits limits = getRequiredLimits();
-    wgpu::DeviceDescriptor desc({
-        .requiredLimits = &limits,
-    });
-
-    // ReSharper disable once CppParameterMayBeConst
-    // ReSharper disable once CppPassValueParameterByConstReference
-    // The signature needs to match that requested by wgpu
-    auto callback = [](wgpu::RequestDeviceStatus status, wgpu::Device _device,
-                       const char* message, wgpu::Device* result) {
-        if (status != wgpu::RequestDeviceStatus::Success) {
-            std::cerr << "Failed to obtain device: " << std::endl;
-            return;
-        }
-        *result = std::move(_device);
-    };
-
-    wgpu::Future future = adapter.RequestDevice(
-        &desc, wgpu::CallbackMode::WaitAnyOnly, callback, &device);
-    instance.WaitAny(future, UINT64_MAX);
-    if (!device) {
-        throw std::runtime_error("Failed to create device. Check logs");
-    }
-    device.SetUncapturedErrorCallback(&debug_callbacks::onUncapturedError,
-                                      nullptr);
-    device.SetDeviceLostCallback(&debug_callbacks::onDeviceLost, nullptr);
+    device = gpu_bootstrap::requestDevice(instance, adapter, &limits);
     queue = device.GetQueue();
     if (!queue) {
         throw std::runtime_error("Failed to create queue. Check logs");
@@ -265,7 +355,7 @@ void App::initBuffers() {
     };
 
     vertexBuffer = device.CreateBuffer(&vertex_desc);
-    queue.WriteBuffer(vertexBuffer, 0, data.vertex.data(), vertex_desc.size);
+    writeBuffer(vertexBuffer, 0, data.vertex.data(), vertex_desc.size);
 
     wgpu::BufferDescriptor index_desc{
         .label = "Index Buffer",
@@ -277,25 +367,38 @@ void App::initBuffers() {
     };
 
     indexBuffer = device.CreateBuffer(&index_desc);
-    queue.WriteBuffer(indexBuffer, 0, data.index.data(), index_desc.size);
+    writeBuffer(indexBuffer, 0, data.index.data(), index_desc.size);
 
     wgpu::BufferDescriptor uniformDesc{
         .label = "Uniform Buffer",
         .usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform,
-        .size = align4(sizeof(float)),
+        .size = align4(sizeof(Uniforms)),
         .mappedAtCreation = false,
     };
 
     uniformBuffer = device.CreateBuffer(&uniformDesc);
-    constexpr float initTime = 1.0f;
-    queue.WriteBuffer(uniformBuffer, 0, &initTime, sizeof(float));
+    uniforms = {
+        .time = 1.0f,
+        .aspectRatio = static_cast<float>(dimensions.width) /
+                       static_cast<float>(dimensions.height),
+        .offset = {-0.6874f, -0.463f},
+    };
+    writeBuffer(uniformBuffer, 0, &uniforms, sizeof(uniforms));
 }
 
 wgpu::TextureView App::getNextTextureView() {
     wgpu::SurfaceTexture tex;
     surface.GetCurrentTexture(&tex);
-    if (tex.status != wgpu::SurfaceGetCurrentTextureStatus::Success) {
-        return nullptr;
+    switch (tex.status) {
+        case wgpu::SurfaceGetCurrentTextureStatus::Success:
+            break;
+        case wgpu::SurfaceGetCurrentTextureStatus::Outdated:
+        case wgpu::SurfaceGetCurrentTextureStatus::Lost: {
+            configureSurface();
+            return nullptr;
+        }
+        default:
+            return nullptr;
     }
 
     wgpu::TextureViewDescriptor desc{
@@ -325,7 +428,7 @@ void App::createRenderPipeline() {
             .shaderLocation = 1,
         }};  // colour
     wgpu::VertexBufferLayout vbl{
-        .arrayStride = 5 * sizeof(float),
+        .arrayStride = kComponentsPerVertex * sizeof(float),
         .stepMode = wgpu::VertexStepMode::Vertex,
         .attributeCount = attribs.size(),
         .attributes = attribs.data(),
@@ -383,7 +486,7 @@ void App::createRenderPipeline() {
         .visibility = wgpu::ShaderStage::Vertex,
         .buffer{
             .type = wgpu::BufferBindingType::Uniform,
-            .minBindingSize = sizeof(float),
+            .minBindingSize = sizeof(Uniforms),
         },
     };
     wgpu::BindGroupLayoutDescriptor bgl_desc{
@@ -396,7 +499,7 @@ void App::createRenderPipeline() {
         .binding = 0,
         .buffer = uniformBuffer,
         .offset = 0,
-        .size = sizeof(float),
+        .size = sizeof(Uniforms),
     };
 
     wgpu::BindGroupDescriptor bg_desc{
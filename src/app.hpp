@@ -6,12 +6,28 @@
 #include <GLFW/glfw3.h>
 #include <webgpu/webgpu_cpp.h>
 
+#include "bvh.hpp"
 #include "loader.hpp"
+#include "loop_stats.hpp"
+#include "metrics.hpp"
 
 constexpr auto align4(const size_t& size) -> size_t {
     return (size + 3U) & ~3U;
 };
 
+// Layout of the Uniforms struct in shader.wgsl, the single source of the
+// vertex transform for both the shader and cursorToMesh()
+struct Uniforms {
+    float time;
+    float aspectRatio;
+    float offset[2];
+};
+
+enum class RedrawMode {
+    Continuous,  // render every iteration, as fast as the present mode allows
+    OnDemand,    // sleep in the event loop until something needs redrawing
+};
+
 struct App {
    private:
     gsl::final_action<void (*)()> onDestroy;
@@ -29,12 +45,20 @@ struct App {
     wgpu::RenderPipeline pipeline;
 
     Data data;
+    MeshBvh meshBvh;
 
     // buffers
     wgpu::Buffer vertexBuffer, indexBuffer, uniformBuffer;
 
     wgpu::Extent2D dimensions;
 
+    RedrawMode redrawMode = RedrawMode::OnDemand;
+    // Toggled with space, paused OnDemand sessions sleep until input
+    bool animating = true;
+    double animationInterval = 1.0 / 60.0;
+    LoopStats stats{5.0};
+    metrics::Exporter metricsExporter = metrics::Exporter::fromEnvironment();
+
     void createSurface();
     void createWindow(const wgpu::Extent2D& dims);
     void initWebGPU();
@@ -55,7 +79,36 @@ struct App {
 
     void run() noexcept;
 
+    // Marks the frame dirty, e.g. after updating data. Must be called from the
+    // main thread, other threads should post a task and glfwPostEmptyEvent()
+    void requestRedraw();
+
    private:
+    bool needsRedraw = true;
+    float animationTime = 0.0f;
+    // Last values written to uniformBuffer, i.e. what is on screen
+    Uniforms uniforms{};
+    double nextAnimationFrame = 0.0;
+    double acquireBackoff = 0.0;
+
+    void waitForEvents();
+
+    static void onKey(GLFWwindow* window,
+                      int key,
+                      int scancode,
+                      int action,
+                      int mods);
+
+    static void onRefresh(GLFWwindow* window);
+
+    static void onMouseButton(GLFWwindow* window,
+                              int button,
+                              int action,
+                              int mods);
+
+    // Inverse of the vs_main transform, cursor position to mesh space
+    auto cursorToMesh(double x, double y) const -> Vec2;
+
     void createInstance();
 
     void requestAdapter();
@@ -70,6 +123,12 @@ struct App {
 
     void render(const wgpu::TextureView& targetView);
 
+    // Queue::WriteBuffer, counted into the upload metrics
+    void writeBuffer(const wgpu::Buffer& buffer,
+                     uint64_t offset,
+                     const void* data,
+                     size_t size);
+
     void configureSurface();
 
     void loadShaders();
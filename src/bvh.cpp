@@ -0,0 +1,348 @@
+#include "bvh.hpp"
+
+#include <array>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/format.h>
+
+namespace {
+
+constexpr size_t kBinCount = 16;
+constexpr uint32_t kMinLeafSize = 2;
+constexpr uint32_t kMaxLeafSize = 16;
+// Relative to the cost of testing one primitive
+constexpr float kTraversalCost = 1.0f;
+// Subtrees smaller than this aren't worth a thread
+constexpr uint32_t kParallelThreshold = 1U << 14;
+
+auto resolveThreads(unsigned threadCount) -> unsigned {
+    return threadCount > 0 ? threadCount
+                           : std::max(1U, std::thread::hardware_concurrency());
+}
+
+// Runs body(begin, end) over contiguous chunks of [0, count)
+template <typename Body>
+void parallelFor(size_t count, unsigned threadCount, Body&& body) {
+    const size_t chunks = std::min<size_t>(threadCount, count / 4096 + 1);
+    const size_t chunkSize = (count + chunks - 1) / std::max<size_t>(chunks, 1);
+    std::vector<std::thread> workers;
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        const size_t begin = std::min(count, chunk * chunkSize);
+        const size_t end = std::min(count, begin + chunkSize);
+        workers.emplace_back([&body, begin, end] { body(begin, end); });
+    }
+    body(0, std::min(count, chunkSize));
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+auto axisOf(const Vec2& v, int axis) -> float {
+    return axis == 0 ? v.x : v.y;
+}
+
+// Maps centroids along one axis onto the bins
+struct Binning {
+    int axis;
+    float lo;
+    float scale;
+
+    Binning(const Aabb& centroidBounds, int axis)
+        : axis(axis),
+          lo(axisOf(centroidBounds.min, axis)),
+          scale(kBinCount / (axisOf(centroidBounds.max, axis) - lo)) {}
+
+    auto operator()(const Vec2& centroid) const -> size_t {
+        const auto bin =
+            static_cast<size_t>((axisOf(centroid, axis) - lo) * scale);
+        return std::min(bin, kBinCount - 1);
+    }
+};
+
+struct Split {
+    float cost = std::numeric_limits<float>::max();
+    int axis = -1;
+    size_t bin = 0;
+    Aabb left, right;
+};
+
+struct Builder {
+    gsl::span<const Aabb> bounds;
+    std::vector<Vec2> centroids;
+    std::vector<BvhNode>& nodes;
+    std::vector<uint32_t>& primitives;
+    std::atomic<uint32_t> nodeCount{1};
+    size_t parallelDepth = 0;
+
+    auto findSplit(uint32_t first,
+                   uint32_t count,
+                   const Aabb& centroidBounds) const -> Split {
+        Split best;
+        for (int axis = 0; axis < 2; ++axis) {
+            if (axisOf(centroidBounds.max, axis) <=
+                axisOf(centroidBounds.min, axis)) {
+                continue;
+            }
+            const Binning binOf(centroidBounds, axis);
+            std::array<Aabb, kBinCount> binBounds{};
+            std::array<uint32_t, kBinCount> binCounts{};
+            for (uint32_t i = first; i < first + count; ++i) {
+                const uint32_t prim = primitives[i];
+                const size_t bin = binOf(centroids[prim]);
+                binBounds[bin].grow(bounds[prim]);
+                ++binCounts[bin];
+            }
+
+            // suffix sweep, then evaluate every plane in a prefix sweep
+            std::array<Aabb, kBinCount> rightBounds{};
+            std::array<uint32_t, kBinCount> rightCounts{};
+            Aabb accumulated;
+            uint32_t accumulatedCount = 0;
+            for (size_t bin = kBinCount - 1; bin > 0; --bin) {
+                accumulated.grow(binBounds[bin]);
+                accumulatedCount += binCounts[bin];
+                rightBounds[bin] = accumulated;
+                rightCounts[bin] = accumulatedCount;
+            }
+            Aabb left;
+            uint32_t leftCount = 0;
+            for (size_t plane = 1; plane < kBinCount; ++plane) {
+                left.grow(binBounds[plane - 1]);
+                leftCount += binCounts[plane - 1];
+                if (leftCount == 0 || rightCounts[plane] == 0) {
+                    continue;
+                }
+                const float cost =
+                    left.halfPerimeter() * static_cast<float>(leftCount) +
+                    rightBounds[plane].halfPerimeter() *
+                        static_cast<float>(rightCounts[plane]);
+                if (cost < best.cost) {
+                    best = Split{cost, axis, plane, left, rightBounds[plane]};
+                }
+            }
+        }
+        return best;
+    }
+
+    void subdivide(uint32_t nodeIndex, size_t depth) {
+        BvhNode& node = nodes[nodeIndex];
+        const uint32_t first = node.first;
+        const uint32_t count = node.count;
+        if (count <= kMinLeafSize || depth >= Bvh::kMaxDepth) {
+            return;
+        }
+
+        Aabb centroidBounds;
+        for (uint32_t i = first; i < first + count; ++i) {
+            centroidBounds.grow(centroids[primitives[i]]);
+        }
+        const Split split = findSplit(first, count, centroidBounds);
+        const float area = node.bounds.halfPerimeter();
+        const float leafCost = area * static_cast<float>(count);
+        const bool splitPays =
+            split.axis >= 0 && kTraversalCost * area + split.cost < leafCost;
+        if (!splitPays && count <= kMaxLeafSize) {
+            return;
+        }
+
+        auto* begin = primitives.data() + first;
+        auto* end = begin + count;
+        uint32_t* middle;
+        Aabb leftBounds, rightBounds;
+        if (split.axis >= 0) {
+            const Binning binOf(centroidBounds, split.axis);
+            middle = std::partition(begin, end, [&](uint32_t prim) {
+                return binOf(centroids[prim]) < split.bin;
+            });
+            leftBounds = split.left;
+            rightBounds = split.right;
+        } else {
+            // all centroids coincide, halve to keep leaves small
+            middle = begin + count / 2;
+            for (uint32_t* it = begin; it != end; ++it) {
+                (it < middle ? leftBounds : rightBounds).grow(bounds[*it]);
+            }
+        }
+
+        const auto leftCount = static_cast<uint32_t>(middle - begin);
+        const uint32_t left = nodeCount.fetch_add(2);
+        nodes[left] = BvhNode{leftBounds, first, leftCount};
+        nodes[left + 1] = BvhNode{rightBounds, first + leftCount,
+                                  count - leftCount};
+        node.first = left;
+        node.count = 0;
+
+        if (depth < parallelDepth && count >= kParallelThreshold) {
+            std::thread worker([this, left, depth] {
+                subdivide(left, depth + 1);
+            });
+            subdivide(left + 1, depth + 1);
+            worker.join();
+        } else {
+            subdivide(left, depth + 1);
+            subdivide(left + 1, depth + 1);
+        }
+    }
+};
+
+auto vertexAt(const Data& data, uint16_t index) -> Vec2 {
+    return {data.vertex[index * kComponentsPerVertex],
+            data.vertex[index * kComponentsPerVertex + 1]};
+}
+
+void extractTriangles(const Data& data,
+                      std::vector<Triangle>& triangles,
+                      unsigned threadCount) {
+    const size_t vertexCount = data.vertex.size() / kComponentsPerVertex;
+    const size_t triangleCount = data.index.size() / 3;
+    const auto maxIndex = std::max_element(data.index.begin(),
+                                           data.index.end());
+    if (maxIndex != data.index.end() && *maxIndex >= vertexCount) {
+        throw std::runtime_error(
+            fmt::format("Index {} is out of range for {} vertices", *maxIndex,
+                        vertexCount));
+    }
+    triangles.resize(triangleCount);
+    parallelFor(triangleCount, threadCount, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            triangles[i] = Triangle{vertexAt(data, data.index[3 * i]),
+                                    vertexAt(data, data.index[3 * i + 1]),
+                                    vertexAt(data, data.index[3 * i + 2])};
+        }
+    });
+}
+
+void computeBounds(const std::vector<Triangle>& triangles,
+                   std::vector<Aabb>& bounds,
+                   unsigned threadCount) {
+    bounds.resize(triangles.size());
+    parallelFor(triangles.size(), threadCount, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            bounds[i] = triangles[i].bounds();
+        }
+    });
+}
+
+}  // namespace
+
+void Bvh::build(gsl::span<const Aabb> bounds, unsigned threadCount) {
+    const size_t count = bounds.size();
+    if (count > std::numeric_limits<uint32_t>::max() / 2) {
+        throw std::runtime_error("Too many primitives for a BVH");
+    }
+    threadCount = resolveThreads(threadCount);
+    nodeArray.clear();
+    primitiveArray.resize(count);
+    std::iota(primitiveArray.begin(), primitiveArray.end(), 0U);
+    if (count == 0) {
+        return;
+    }
+
+    Builder builder{bounds, std::vector<Vec2>(count), nodeArray,
+                    primitiveArray};
+    parallelFor(count, threadCount, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            builder.centroids[i] = bounds[i].centre();
+        }
+    });
+    while ((size_t{1} << builder.parallelDepth) < threadCount) {
+        ++builder.parallelDepth;
+    }
+
+    Aabb root;
+    for (const Aabb& box : bounds) {
+        root.grow(box);
+    }
+    nodeArray.resize(2 * count - 1);
+    nodeArray[0] = BvhNode{root, 0, static_cast<uint32_t>(count)};
+    builder.subdivide(0, 0);
+    nodeArray.resize(builder.nodeCount);
+}
+
+void Bvh::refit(gsl::span<const Aabb> bounds) {
+    if (bounds.size() != primitiveArray.size()) {
+        throw std::runtime_error("BVH refit with a different primitive count");
+    }
+    for (size_t i = nodeArray.size(); i-- > 0;) {
+        BvhNode& node = nodeArray[i];
+        Aabb box;
+        if (node.count > 0) {
+            for (uint32_t p = 0; p < node.count; ++p) {
+                box.grow(bounds[primitiveArray[node.first + p]]);
+            }
+        } else {
+            box.grow(nodeArray[node.first].bounds);
+            box.grow(nodeArray[node.first + 1].bounds);
+        }
+        node.bounds = box;
+    }
+}
+
+auto Triangle::bounds() const -> Aabb {
+    Aabb box;
+    box.grow(a);
+    box.grow(b);
+    box.grow(c);
+    return box;
+}
+
+auto Triangle::contains(const Vec2& p) const -> bool {
+    auto edge = [&](const Vec2& from, const Vec2& to) {
+        return (to.x - from.x) * (p.y - from.y) -
+               (to.y - from.y) * (p.x - from.x);
+    };
+    const float d0 = edge(a, b);
+    const float d1 = edge(b, c);
+    const float d2 = edge(c, a);
+    const bool negative = (d0 < 0.0f) | (d1 < 0.0f) | (d2 < 0.0f);
+    const bool positive = (d0 > 0.0f) | (d1 > 0.0f) | (d2 > 0.0f);
+    return !(negative && positive);
+}
+
+void MeshBvh::build(const Data& data, unsigned threadCount) {
+    threadCount = resolveThreads(threadCount);
+    std::vector<Triangle> triangles;
+    extractTriangles(data, triangles, threadCount);
+    build(std::move(triangles), threadCount);
+}
+
+void MeshBvh::build(std::vector<Triangle> triangles, unsigned threadCount) {
+    threadCount = resolveThreads(threadCount);
+    triangleArray = std::move(triangles);
+    computeBounds(triangleArray, boundsArray, threadCount);
+    tree.build(boundsArray, threadCount);
+}
+
+void MeshBvh::refit(const Data& data) {
+    if (data.index.size() / 3 != triangleArray.size()) {
+        throw std::runtime_error("Mesh topology changed since the BVH build");
+    }
+    const unsigned threadCount = resolveThreads(0);
+    extractTriangles(data, triangleArray, threadCount);
+    computeBounds(triangleArray, boundsArray, threadCount);
+    tree.refit(boundsArray);
+}
+
+auto MeshBvh::pick(const Vec2& point) const -> std::optional<uint32_t> {
+    std::optional<uint32_t> topmost;
+    tree.queryPoint(point, [&](uint32_t triangle) {
+        if ((!topmost || triangle > *topmost) &&
+            triangleArray[triangle].contains(point)) {
+            topmost = triangle;
+        }
+    });
+    return topmost;
+}
+
+auto MeshBvh::cull(const Aabb& view) const -> std::vector<uint32_t> {
+    std::vector<uint32_t> visible;
+    tree.queryBox(view, [&](uint32_t triangle) {
+        if (boundsArray[triangle].overlaps(view)) {
+            visible.push_back(triangle);
+        }
+    });
+    return visible;
+}
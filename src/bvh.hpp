@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <gsl/span>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "loader.hpp"
+
+struct Vec2 {
+    float x, y;
+};
+
+struct Aabb {
+    Vec2 min{std::numeric_limits<float>::max(),
+             std::numeric_limits<float>::max()};
+    Vec2 max{std::numeric_limits<float>::lowest(),
+             std::numeric_limits<float>::lowest()};
+
+    void grow(const Vec2& p) {
+        min = {std::min(min.x, p.x), std::min(min.y, p.y)};
+        max = {std::max(max.x, p.x), std::max(max.y, p.y)};
+    }
+
+    void grow(const Aabb& other) {
+        min = {std::min(min.x, other.min.x), std::min(min.y, other.min.y)};
+        max = {std::max(max.x, other.max.x), std::max(max.y, other.max.y)};
+    }
+
+    // 2D analogue of the surface area used by the SAH
+    auto halfPerimeter() const -> float {
+        return std::max(0.0f, max.x - min.x) + std::max(0.0f, max.y - min.y);
+    }
+
+    auto centre() const -> Vec2 {
+        return {0.5f * (min.x + max.x), 0.5f * (min.y + max.y)};
+    }
+
+    auto contains(const Vec2& p) const -> bool {
+        return (p.x >= min.x) & (p.x <= max.x) & (p.y >= min.y) &
+               (p.y <= max.y);
+    }
+
+    auto overlaps(const Aabb& other) const -> bool {
+        return (other.max.x >= min.x) & (other.min.x <= max.x) &
+               (other.max.y >= min.y) & (other.min.y <= max.y);
+    }
+};
+
+/**
+ * Leaves hold count > 0 primitives starting at first, interior nodes have
+ * count == 0 and their children at first and first + 1.
+ */
+struct BvhNode {
+    Aabb bounds;
+    uint32_t first;
+    uint32_t count;
+};
+
+/**
+ * Bounding volume hierarchy over axis aligned boxes, built with a binned
+ * surface area heuristic into one contiguous node array. Children are always
+ * stored after their parent, which lets refit() run as a single reverse
+ * sweep.
+ */
+class Bvh {
+   public:
+    /**
+     * @param threadCount Upper bound on build threads, 0 uses the hardware
+     * concurrency.
+     */
+    void build(gsl::span<const Aabb> bounds, unsigned threadCount = 0);
+
+    // Updates the node bounds for moved primitives, keeping the topology
+    void refit(gsl::span<const Aabb> bounds);
+
+    // Calls visit(primitive) for every primitive whose leaf contains p
+    template <typename Visit>
+    void queryPoint(const Vec2& p, Visit&& visit) const {
+        query([&](const Aabb& box) { return box.contains(p); }, visit);
+    }
+
+    // Calls visit(primitive) for every primitive whose leaf overlaps box
+    template <typename Visit>
+    void queryBox(const Aabb& box, Visit&& visit) const {
+        query([&](const Aabb& node) { return node.overlaps(box); }, visit);
+    }
+
+    auto nodes() const -> const std::vector<BvhNode>& { return nodeArray; }
+
+    // Primitive indices, in leaf order
+    auto primitives() const -> const std::vector<uint32_t>& {
+        return primitiveArray;
+    }
+
+    static constexpr size_t kMaxDepth = 48;
+
+   private:
+    std::vector<BvhNode> nodeArray;
+    std::vector<uint32_t> primitiveArray;
+
+    template <typename Test, typename Visit>
+    void query(Test&& test, Visit&& visit) const {
+        if (nodeArray.empty()) {
+            return;
+        }
+        uint32_t stack[kMaxDepth + 2];
+        size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = nodeArray[stack[--top]];
+            if (!test(node.bounds)) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    visit(primitiveArray[node.first + i]);
+                }
+            } else {
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+            }
+        }
+    }
+};
+
+struct Triangle {
+    Vec2 a, b, c;
+
+    auto bounds() const -> Aabb;
+
+    // Inclusive of the edges, for either winding
+    auto contains(const Vec2& p) const -> bool;
+};
+
+/**
+ * Spatial index over the triangles of a Data mesh, for picking and culling.
+ * Triangle i is made of data.index[3 * i] to data.index[3 * i + 2].
+ */
+class MeshBvh {
+   public:
+    void build(const Data& data, unsigned threadCount = 0);
+
+    void build(std::vector<Triangle> triangles, unsigned threadCount = 0);
+
+    // For animated vertices, the index buffer must be unchanged since build
+    void refit(const Data& data);
+
+    // Topmost triangle under point, i.e. the one drawn last
+    auto pick(const Vec2& point) const -> std::optional<uint32_t>;
+
+    // Triangles whose bounds overlap the view, in no particular order
+    auto cull(const Aabb& view) const -> std::vector<uint32_t>;
+
+    auto bvh() const -> const Bvh& { return tree; }
+
+    auto triangles() const -> const std::vector<Triangle>& {
+        return triangleArray;
+    }
+
+   private:
+    std::vector<Triangle> triangleArray;
+    std::vector<Aabb> boundsArray;
+    Bvh tree;
+};
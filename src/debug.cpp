@@ -6,6 +6,7 @@
 #include <fmt/base.h>
 #include <fmt/format.h>
 
+#include "metrics.hpp"
 #include "webgpu/webgpu_cpp.h"
 
 namespace debug_callbacks {
@@ -24,6 +25,8 @@ void onDeviceLost(WGPUDeviceLostReason reason, const char* _message, void*) {
             return;
         }
         default: {
+            // destruction and instance drops are normal teardown
+            metrics::add(metrics::Counter::DeviceLost);
             fmt::println("webGPU device lost {}: {}", static_cast<int>(reason),
                          message);
             return;
@@ -33,18 +36,23 @@ void onDeviceLost(WGPUDeviceLostReason reason, const char* _message, void*) {
 
 void onUncapturedError(WGPUErrorType err, const char* _message, void*) {
     std::string message = _message ? _message : "";
+    metrics::add(metrics::Counter::DeviceErrors);
     fmt::println("Uncaptured webGPU error {}: {}", static_cast<int>(err),
                  message);
 };
 
 void logGLFW(int err, const char* _message) {
     std::string message = _message ? _message : "";
+    metrics::add(metrics::Counter::GlfwErrors);
     fmt::println("GLFW returned error {}: {}", err, message);
 };
 
 void onMapAsync(wgpu::MapAsyncStatus status, const char* _message) {
     std::string message = _message ? _message : "";
     using Status = wgpu::MapAsyncStatus;
+    if (status != Status::Success) {
+        metrics::add(metrics::Counter::MapAsyncFailures);
+    }
     switch (status) {
         case Status::Success: {
             fmt::println(stderr, "Operation success: {}", message);
@@ -0,0 +1,87 @@
+#include "gpu_bootstrap.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+#include "debug.hpp"
+
+namespace gpu_bootstrap {
+
+auto createInstance() -> wgpu::Instance {
+    wgpu::InstanceDescriptor desc{
+        .features{
+            .timedWaitAnyEnable = true,
+        },
+    };
+    wgpu::Instance instance = wgpu::CreateInstance(&desc);
+    if (!instance) {
+        throw std::runtime_error("Failed to create webGPU instance.");
+    }
+    return instance;
+}
+
+auto requestAdapter(const wgpu::Instance& instance,
+                    const wgpu::Surface& compatibleSurface,
+                    bool forceFallbackAdapter) -> wgpu::Adapter {
+    wgpu::RequestAdapterOptions opts{
+        .compatibleSurface = compatibleSurface,
+        .forceFallbackAdapter = forceFallbackAdapter,
+    };
+
+    // ReSharper disable once CppParameterMayBeConst
+    // ReSharper disable once CppPassValueParameterByConstReference
+    // The signature needs to match that requested by wgpu
+    auto callback = [](wgpu::RequestAdapterStatus status,
+                       wgpu::Adapter _adapter, const char* message,
+                       wgpu::Adapter* result) {
+        if (status != wgpu::RequestAdapterStatus::Success) {
+            std::cerr << "Failed to obtain adapter: " << std::endl;
+            return;
+        }
+        *result = std::move(_adapter);
+    };
+
+    wgpu::Adapter adapter;
+    wgpu::Future future = instance.RequestAdapter(
+        &opts, wgpu::CallbackMode::WaitAnyOnly, callback, &adapter);
+    instance.WaitAny(future, UINT64_MAX);
+    if (!adapter) {
+        throw std::runtime_error("Failed to create adapter. Check logs");
+    }
+    return adapter;
+}
+
+auto requestDevice(const wgpu::Instance& instance,
+                   const wgpu::Adapter& adapter,
+                   const wgpu::RequiredLimits* limits) -> wgpu::Device {
+    wgpu::DeviceDescriptor desc({
+        .requiredLimits = limits,
+    });
+
+    // ReSharper disable once CppParameterMayBeConst
+    // ReSharper disable once CppPassValueParameterByConstReference
+    // The signature needs to match that requested by wgpu
+    auto callback = [](wgpu::RequestDeviceStatus status, wgpu::Device _device,
+                       const char* message, wgpu::Device* result) {
+        if (status != wgpu::RequestDeviceStatus::Success) {
+            std::cerr << "Failed to obtain device: " << std::endl;
+            return;
+        }
+        *result = std::move(_device);
+    };
+
+    wgpu::Device device;
+    wgpu::Future future = adapter.RequestDevice(
+        &desc, wgpu::CallbackMode::WaitAnyOnly, callback, &device);
+    instance.WaitAny(future, UINT64_MAX);
+    if (!device) {
+        throw std::runtime_error("Failed to create device. Check logs");
+    }
+    device.SetUncapturedErrorCallback(&debug_callbacks::onUncapturedError,
+                                      nullptr);
+    device.SetDeviceLostCallback(&debug_callbacks::onDeviceLost, nullptr);
+    return device;
+}
+
+}  // namespace gpu_bootstrap
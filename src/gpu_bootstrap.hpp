@@ -0,0 +1,21 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+
+/**
+ * Instance, adapter and device creation shared by App and the headless
+ * tools. All of these throw std::runtime_error on failure.
+ */
+namespace gpu_bootstrap {
+auto createInstance() -> wgpu::Instance;
+
+// compatibleSurface may be null when running headless
+auto requestAdapter(const wgpu::Instance& instance,
+                    const wgpu::Surface& compatibleSurface,
+                    bool forceFallbackAdapter = false) -> wgpu::Adapter;
+
+// Installs the debug_callbacks error and device lost handlers. A null limits
+// pointer requests the defaults
+auto requestDevice(const wgpu::Instance& instance,
+                   const wgpu::Adapter& adapter,
+                   const wgpu::RequiredLimits* limits) -> wgpu::Device;
+}  // namespace gpu_bootstrap
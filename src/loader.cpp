@@ -8,7 +8,14 @@
 
 #include <fmt/format.h>
 
+#include "mesh_codec.hpp"
+
 void Data::load(const fs::path& path) {
+    if (path.extension() == mesh_codec::kFileExtension) {
+        mesh_codec::decode(mesh_codec::readFile(path), *this);
+        return;
+    }
+
     std::ifstream file(path);
     if (!file.is_open()) {
         throw std::runtime_error(fmt::format("Failed to open file {}", path.c_str()));
@@ -38,7 +45,7 @@ void Data::load(const fs::path& path) {
             continue;
         } else if (currentSection == Section::Points) {
             std::istringstream iss(line);
-            for (int i = 0; i < 5; ++i) {
+            for (size_t i = 0; i < kComponentsPerVertex; ++i) {
                 iss >> val;
                 vertex.push_back(val);
             }
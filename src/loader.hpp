@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
 
 #include "aligned_alloc.hpp"
 
 namespace fs = std::filesystem;
 
+// Floats per vertex in Data::vertex: position xy then colour rgb
+constexpr size_t kComponentsPerVertex = 5;
+
 class Data {
    public:
     alignedVector<float> vertex;
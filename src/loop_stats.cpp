@@ -0,0 +1,92 @@
+#include "loop_stats.hpp"
+
+#include <limits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <fmt/base.h>
+#include <fmt/format.h>
+
+#include "metrics.hpp"
+
+LoopStats::LoopStats(double reportInterval) : reportInterval(reportInterval) {}
+
+void LoopStats::onWakeup() {
+    ++wakeups;
+    metrics::add(metrics::Counter::Wakeups);
+}
+
+void LoopStats::onFrame() {
+    ++frames;
+    metrics::add(metrics::Counter::Frames);
+}
+
+void LoopStats::onAcquireFailure() {
+    ++acquireFailures;
+    metrics::add(metrics::Counter::SurfaceAcquireFailures);
+}
+
+void LoopStats::maybeReport(double now) {
+    if (reportInterval <= 0.0) {
+        return;
+    }
+    if (!started) {
+        windowStart = now;
+        cpuStart = processCpuSeconds();
+        started = true;
+        return;
+    }
+    const double elapsed = now - windowStart;
+    if (elapsed < reportInterval) {
+        return;
+    }
+
+    const double cpu = processCpuSeconds();
+    fmt::println(
+        "loop: {:.1f} frames/s, {:.1f} wakeups/s, {:.1f}% cpu, {} surface "
+        "acquire failures",
+        frames / elapsed, wakeups / elapsed, 100.0 * (cpu - cpuStart) / elapsed,
+        acquireFailures);
+
+    wakeups = frames = acquireFailures = 0;
+    windowStart = now;
+    cpuStart = cpu;
+}
+
+auto LoopStats::nextReport() const -> double {
+    if (reportInterval <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return started ? windowStart + reportInterval : 0.0;
+}
+
+auto processCpuSeconds() -> double {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel,
+                         &user)) {
+        return 0.0;
+    }
+    auto toSeconds = [](const FILETIME& time) {
+        ULARGE_INTEGER ticks{};
+        ticks.LowPart = time.dwLowDateTime;
+        ticks.HighPart = time.dwHighDateTime;
+        return static_cast<double>(ticks.QuadPart) * 1e-7;  // 100ns ticks
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    auto toSeconds = [](const timeval& time) {
+        return static_cast<double>(time.tv_sec) +
+               static_cast<double>(time.tv_usec) * 1e-6;
+    };
+    return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+#endif
+}
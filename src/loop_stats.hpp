@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Tracks how much work the render loop does per unit of wall time, so idle
+ * sessions can be checked to really be idle. Times are in seconds.
+ */
+class LoopStats {
+   public:
+    explicit LoopStats(double reportInterval);
+
+    void onWakeup();
+
+    void onFrame();
+
+    void onAcquireFailure();
+
+    // Prints and resets the counters once reportInterval has elapsed
+    void maybeReport(double now);
+
+    // When maybeReport() next has something to print, infinity if disabled
+    auto nextReport() const -> double;
+
+    // Interval between reports, or <= 0 to disable reporting
+    double reportInterval;
+
+   private:
+    uint64_t wakeups = 0;
+    uint64_t frames = 0;
+    uint64_t acquireFailures = 0;
+    double windowStart = 0.0;
+    double cpuStart = 0.0;
+    bool started = false;
+};
+
+// CPU time consumed by the whole process, user and system
+auto processCpuSeconds() -> double;
@@ -0,0 +1,499 @@
+#include "mesh_codec.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/format.h>
+#include <lz4.h>
+#include <lz4hc.h>
+
+namespace mesh_codec {
+namespace {
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t componentsPerVertex;
+    uint32_t vertexCount;  // in vertices, not floats
+    uint32_t indexCount;
+    uint32_t verticesPerBlock;
+    uint32_t indicesPerBlock;
+    uint32_t vertexBlockCount;
+    uint32_t indexBlockCount;
+    float minimum[kComponentsPerVertex];
+    float scale[kComponentsPerVertex];  // value = minimum + quantized * scale
+};
+
+struct BlockEntry {
+    uint64_t offset;  // from the start of the blob
+    uint32_t compressedSize;
+    uint32_t rawSize;
+};
+
+// Serialised sizes, fields are written one by one in little-endian order
+constexpr size_t kHeaderSize = 9 * sizeof(uint32_t) +
+                               2 * kComponentsPerVertex * sizeof(float);
+constexpr size_t kBlockEntrySize = sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+class ByteWriter {
+   public:
+    explicit ByteWriter(std::byte* out) : out(out) {}
+
+    void u32(uint32_t value) { put(value, 4); }
+
+    void u64(uint64_t value) { put(value, 8); }
+
+    void f32(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+
+   private:
+    std::byte* out;
+
+    void put(uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            *out++ = static_cast<std::byte>(value >> (8 * i));
+        }
+    }
+};
+
+class ByteReader {
+   public:
+    explicit ByteReader(const std::byte* in) : in(in) {}
+
+    auto u32() -> uint32_t { return static_cast<uint32_t>(get(4)); }
+
+    auto u64() -> uint64_t { return get(8); }
+
+    auto f32() -> float {
+        const uint32_t bits = u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+   private:
+    const std::byte* in;
+
+    auto get(size_t bytes) -> uint64_t {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= std::to_integer<uint64_t>(*in++) << (8 * i);
+        }
+        return value;
+    }
+};
+
+void writeHeader(const FileHeader& header, std::byte* out) {
+    ByteWriter writer(out);
+    for (const uint32_t field :
+         {header.magic, header.version, header.componentsPerVertex,
+          header.vertexCount, header.indexCount, header.verticesPerBlock,
+          header.indicesPerBlock, header.vertexBlockCount,
+          header.indexBlockCount}) {
+        writer.u32(field);
+    }
+    for (const float minimum : header.minimum) {
+        writer.f32(minimum);
+    }
+    for (const float scale : header.scale) {
+        writer.f32(scale);
+    }
+}
+
+auto readHeader(const std::byte* in) -> FileHeader {
+    ByteReader reader(in);
+    FileHeader header{};
+    for (uint32_t* field :
+         {&header.magic, &header.version, &header.componentsPerVertex,
+          &header.vertexCount, &header.indexCount, &header.verticesPerBlock,
+          &header.indicesPerBlock, &header.vertexBlockCount,
+          &header.indexBlockCount}) {
+        *field = reader.u32();
+    }
+    for (float& minimum : header.minimum) {
+        minimum = reader.f32();
+    }
+    for (float& scale : header.scale) {
+        scale = reader.f32();
+    }
+    return header;
+}
+
+struct Layout {
+    FileHeader header;
+    std::vector<BlockEntry> blocks;  // vertex blocks first, then index blocks
+};
+
+constexpr float kQuantizedMax = std::numeric_limits<uint16_t>::max();
+
+constexpr auto zigzag(int16_t value) -> uint16_t {
+    return static_cast<uint16_t>((static_cast<uint16_t>(value) << 1) ^
+                                 static_cast<uint16_t>(value >> 15));
+}
+
+constexpr auto unzigzag(uint16_t value) -> int16_t {
+    return static_cast<int16_t>((value >> 1) ^ -(value & 1));
+}
+
+auto blockCount(size_t count, uint32_t perBlock) -> uint32_t {
+    return static_cast<uint32_t>((count + perBlock - 1) / perBlock);
+}
+
+auto blockLength(size_t count, uint32_t perBlock, size_t block) -> size_t {
+    return std::min<size_t>(perBlock, count - block * perBlock);
+}
+
+// Splits each 16 bit value into a low and a high byte plane, so similar bytes
+// sit next to each other for the compressor
+void shuffle(const uint16_t* values, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<uint8_t>(values[i]);
+        out[n + i] = static_cast<uint8_t>(values[i] >> 8);
+    }
+}
+
+void compressBlock(const std::vector<uint8_t>& raw,
+                   int level,
+                   std::vector<std::byte>& payload,
+                   std::vector<BlockEntry>& entries) {
+    const int bound = LZ4_compressBound(static_cast<int>(raw.size()));
+    const size_t at = payload.size();
+    payload.resize(at + bound);
+    const int written = LZ4_compress_HC(
+        reinterpret_cast<const char*>(raw.data()),
+        reinterpret_cast<char*>(payload.data() + at),
+        static_cast<int>(raw.size()), bound, level);
+    if (written <= 0) {
+        throw std::runtime_error("Failed to compress mesh block");
+    }
+    payload.resize(at + written);
+    entries.push_back(BlockEntry{
+        .offset = at,
+        .compressedSize = static_cast<uint32_t>(written),
+        .rawSize = static_cast<uint32_t>(raw.size()),
+    });
+}
+
+auto parse(gsl::span<const std::byte> blob) -> Layout {
+    Layout layout{};
+    FileHeader& header = layout.header;
+    if (blob.size() < kHeaderSize) {
+        throw std::runtime_error("Mesh blob is too small for its header");
+    }
+    header = readHeader(blob.data());
+    if (header.magic != kMagic) {
+        throw std::runtime_error("Mesh blob has an invalid magic number");
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error(
+            fmt::format("Unsupported mesh blob version {}", header.version));
+    }
+    if (header.componentsPerVertex != kComponentsPerVertex ||
+        header.verticesPerBlock == 0 || header.indicesPerBlock == 0 ||
+        header.vertexBlockCount !=
+            blockCount(header.vertexCount, header.verticesPerBlock) ||
+        header.indexBlockCount !=
+            blockCount(header.indexCount, header.indicesPerBlock)) {
+        throw std::runtime_error("Mesh blob has an inconsistent header");
+    }
+
+    const size_t count = size_t{header.vertexBlockCount} +
+                         header.indexBlockCount;
+    if ((blob.size() - kHeaderSize) / kBlockEntrySize < count) {
+        throw std::runtime_error("Mesh blob is too small for its block table");
+    }
+    layout.blocks.resize(count);
+    ByteReader table(blob.data() + kHeaderSize);
+    for (BlockEntry& entry : layout.blocks) {
+        entry.offset = table.u64();
+        entry.compressedSize = table.u32();
+        entry.rawSize = table.u32();
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const BlockEntry& entry = layout.blocks[i];
+        const size_t expected =
+            i < header.vertexBlockCount
+                ? blockLength(header.vertexCount, header.verticesPerBlock, i) *
+                      kComponentsPerVertex * sizeof(uint16_t)
+                : blockLength(header.indexCount, header.indicesPerBlock,
+                              i - header.vertexBlockCount) *
+                      sizeof(uint16_t);
+        if (entry.rawSize != expected || entry.offset > blob.size() ||
+            entry.compressedSize > blob.size() - entry.offset) {
+            throw std::runtime_error(
+                fmt::format("Mesh blob block {} is out of bounds", i));
+        }
+    }
+    return layout;
+}
+
+void decodeBlock(const Layout& layout,
+                 size_t block,
+                 gsl::span<const std::byte> blob,
+                 std::vector<uint8_t>& scratch,
+                 float* vertexDst,
+                 uint16_t* indexDst) {
+    const FileHeader& header = layout.header;
+    const BlockEntry& entry = layout.blocks[block];
+    scratch.resize(entry.rawSize);
+    const int read = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(blob.data() + entry.offset),
+        reinterpret_cast<char*>(scratch.data()),
+        static_cast<int>(entry.compressedSize),
+        static_cast<int>(entry.rawSize));
+    if (read != static_cast<int>(entry.rawSize)) {
+        throw std::runtime_error(
+            fmt::format("Failed to decompress mesh block {}", block));
+    }
+
+    if (block < header.vertexBlockCount) {
+        const size_t first = block * header.verticesPerBlock;
+        const size_t n =
+            blockLength(header.vertexCount, header.verticesPerBlock, block);
+        float* out = vertexDst + first * kComponentsPerVertex;
+        for (size_t c = 0; c < kComponentsPerVertex; ++c) {
+            const uint8_t* lo = scratch.data() + 2 * c * n;
+            const uint8_t* hi = lo + n;
+            const float minimum = header.minimum[c];
+            const float scale = header.scale[c];
+            for (size_t i = 0; i < n; ++i) {
+                const auto q = static_cast<uint16_t>(lo[i] | (hi[i] << 8));
+                out[i * kComponentsPerVertex + c] =
+                    minimum + static_cast<float>(q) * scale;
+            }
+        }
+        return;
+    }
+
+    block -= header.vertexBlockCount;
+    const size_t first = block * header.indicesPerBlock;
+    const size_t n =
+        blockLength(header.indexCount, header.indicesPerBlock, block);
+    const uint8_t* lo = scratch.data();
+    const uint8_t* hi = lo + n;
+    uint16_t* out = indexDst + first;
+    uint16_t previous = 0;  // deltas restart per block to keep them independent
+    for (size_t i = 0; i < n; ++i) {
+        const auto zz = static_cast<uint16_t>(lo[i] | (hi[i] << 8));
+        previous = static_cast<uint16_t>(previous + unzigzag(zz));
+        out[i] = previous;
+    }
+}
+
+}  // namespace
+
+auto encode(const Data& data, const EncodeOptions& options)
+    -> std::vector<std::byte> {
+    if (data.vertex.size() % kComponentsPerVertex != 0) {
+        throw std::runtime_error(
+            "Vertex data is not a whole number of vertices");
+    }
+    if (options.verticesPerBlock == 0 || options.indicesPerBlock == 0) {
+        throw std::runtime_error("Mesh block sizes must be non-zero");
+    }
+    const size_t vertexCount = data.vertex.size() / kComponentsPerVertex;
+    if (vertexCount > std::numeric_limits<uint32_t>::max() ||
+        data.index.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Mesh is too large to encode");
+    }
+
+    FileHeader header{
+        .magic = kMagic,
+        .version = kVersion,
+        .componentsPerVertex = kComponentsPerVertex,
+        .vertexCount = static_cast<uint32_t>(vertexCount),
+        .indexCount = static_cast<uint32_t>(data.index.size()),
+        .verticesPerBlock = options.verticesPerBlock,
+        .indicesPerBlock = options.indicesPerBlock,
+        .vertexBlockCount = blockCount(vertexCount, options.verticesPerBlock),
+        .indexBlockCount =
+            blockCount(data.index.size(), options.indicesPerBlock),
+        .minimum{},
+        .scale{},
+    };
+
+    for (size_t c = 0; c < kComponentsPerVertex; ++c) {
+        float lo = std::numeric_limits<float>::max();
+        float hi = std::numeric_limits<float>::lowest();
+        for (size_t v = 0; v < vertexCount; ++v) {
+            lo = std::min(lo, data.vertex[v * kComponentsPerVertex + c]);
+            hi = std::max(hi, data.vertex[v * kComponentsPerVertex + c]);
+        }
+        header.minimum[c] = vertexCount > 0 ? lo : 0.0f;
+        header.scale[c] = vertexCount > 0 ? (hi - lo) / kQuantizedMax : 0.0f;
+    }
+
+    std::vector<BlockEntry> entries;
+    entries.reserve(size_t{header.vertexBlockCount} + header.indexBlockCount);
+    std::vector<std::byte> payload;
+    std::vector<uint16_t> values;
+    std::vector<uint8_t> raw;
+
+    for (uint32_t block = 0; block < header.vertexBlockCount; ++block) {
+        const size_t first = size_t{block} * options.verticesPerBlock;
+        const size_t n =
+            blockLength(vertexCount, options.verticesPerBlock, block);
+        values.resize(n * kComponentsPerVertex);
+        // component-major, so each attribute forms its own run of planes
+        for (size_t c = 0; c < kComponentsPerVertex; ++c) {
+            const double inverse =
+                header.scale[c] > 0.0f ? 1.0 / header.scale[c] : 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                const double offset =
+                    data.vertex[(first + i) * kComponentsPerVertex + c] -
+                    header.minimum[c];
+                values[c * n + i] = static_cast<uint16_t>(std::clamp(
+                    std::lround(offset * inverse), 0L, long{UINT16_MAX}));
+            }
+        }
+        raw.resize(values.size() * sizeof(uint16_t));
+        for (size_t c = 0; c < kComponentsPerVertex; ++c) {
+            shuffle(values.data() + c * n, n, raw.data() + 2 * c * n);
+        }
+        compressBlock(raw, options.compressionLevel, payload, entries);
+    }
+
+    for (uint32_t block = 0; block < header.indexBlockCount; ++block) {
+        const size_t first = size_t{block} * options.indicesPerBlock;
+        const size_t n =
+            blockLength(data.index.size(), options.indicesPerBlock, block);
+        values.resize(n);
+        uint16_t previous = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const uint16_t current = data.index[first + i];
+            values[i] = zigzag(static_cast<int16_t>(current - previous));
+            previous = current;
+        }
+        raw.resize(n * sizeof(uint16_t));
+        shuffle(values.data(), n, raw.data());
+        compressBlock(raw, options.compressionLevel, payload, entries);
+    }
+
+    const size_t payloadStart =
+        kHeaderSize + entries.size() * kBlockEntrySize;
+    for (BlockEntry& entry : entries) {
+        entry.offset += payloadStart;
+    }
+
+    std::vector<std::byte> blob(payloadStart + payload.size());
+    writeHeader(header, blob.data());
+    ByteWriter table(blob.data() + kHeaderSize);
+    for (const BlockEntry& entry : entries) {
+        table.u64(entry.offset);
+        table.u32(entry.compressedSize);
+        table.u32(entry.rawSize);
+    }
+    std::copy(payload.begin(), payload.end(), blob.begin() + payloadStart);
+    return blob;
+}
+
+auto peek(gsl::span<const std::byte> blob) -> MeshInfo {
+    const FileHeader header = parse(blob).header;
+    return MeshInfo{
+        .vertexElements = size_t{header.vertexCount} * kComponentsPerVertex,
+        .indexElements = header.indexCount,
+    };
+}
+
+void decode(gsl::span<const std::byte> blob,
+            gsl::span<float> vertexDst,
+            gsl::span<uint16_t> indexDst,
+            unsigned threadCount) {
+    const Layout layout = parse(blob);
+    if (vertexDst.size() <
+            size_t{layout.header.vertexCount} * kComponentsPerVertex ||
+        indexDst.size() < layout.header.indexCount) {
+        throw std::runtime_error("Mesh decode destination is too small");
+    }
+
+    const size_t count = layout.blocks.size();
+    if (threadCount == 0) {
+        threadCount = std::max(1U, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, count));
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto worker = [&] {
+        std::vector<uint8_t> scratch;
+        try {
+            for (size_t block = next++; block < count; block = next++) {
+                decodeBlock(layout, block, blob, scratch, vertexDst.data(),
+                            indexDst.data());
+            }
+        } catch (...) {
+            std::lock_guard lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void decode(gsl::span<const std::byte> blob, Data& data, unsigned threadCount) {
+    const MeshInfo info = peek(blob);
+    data.vertex.resize(info.vertexElements);
+    data.index.resize(info.indexElements);
+    decode(blob, gsl::span<float>(data.vertex.data(), data.vertex.size()),
+           gsl::span<uint16_t>(data.index.data(), data.index.size()),
+           threadCount);
+}
+
+auto readFile(const fs::path& path) -> std::vector<std::byte> {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(
+            fmt::format("Failed to open file {}", path.c_str()));
+    }
+    std::vector<std::byte> blob(fs::file_size(path));
+    file.read(reinterpret_cast<char*>(blob.data()),
+              static_cast<std::streamsize>(blob.size()));
+    if (!file) {
+        throw std::runtime_error(
+            fmt::format("Failed to read file {}", path.c_str()));
+    }
+    return blob;
+}
+
+void writeFile(const fs::path& path, gsl::span<const std::byte> blob) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(
+            fmt::format("Failed to open file {}", path.c_str()));
+    }
+    file.write(reinterpret_cast<const char*>(blob.data()),
+               static_cast<std::streamsize>(blob.size()));
+    if (!file) {
+        throw std::runtime_error(
+            fmt::format("Failed to write file {}", path.c_str()));
+    }
+}
+
+}  // namespace mesh_codec
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <gsl/span>
+#include <vector>
+
+#include "loader.hpp"
+
+/**
+ * Compact binary mesh format (".ldmc").
+ *
+ * Vertex components are quantized to 16 bits against per-component ranges and
+ * byte-shuffled, indices are delta and zig-zag coded, and both streams are
+ * split into independently LZ4 compressed blocks so they can be decoded in
+ * parallel. Header and block table fields are serialised field by field in
+ * little-endian order, independent of the host.
+ */
+namespace mesh_codec {
+constexpr uint32_t kMagic = 0x434D444C;  // "LDMC"
+constexpr uint32_t kVersion = 1;
+constexpr const char* kFileExtension = ".ldmc";
+
+struct EncodeOptions {
+    uint32_t verticesPerBlock = 16384;
+    uint32_t indicesPerBlock = 32768;
+    int compressionLevel = 9;  // LZ4 HC level, only affects encoding
+};
+
+// Element counts matching Data::vertex.size() and Data::index.size()
+struct MeshInfo {
+    size_t vertexElements;
+    size_t indexElements;
+};
+
+auto encode(const Data& data, const EncodeOptions& options = {})
+    -> std::vector<std::byte>;
+
+auto peek(gsl::span<const std::byte> blob) -> MeshInfo;
+
+/**
+ * Decodes straight into caller owned memory, e.g. a buffer mapped at
+ * creation. Destinations must hold at least the element counts from peek().
+ *
+ * @param threadCount Worker count, 0 uses the hardware concurrency.
+ */
+void decode(gsl::span<const std::byte> blob,
+            gsl::span<float> vertexDst,
+            gsl::span<uint16_t> indexDst,
+            unsigned threadCount = 0);
+
+void decode(gsl::span<const std::byte> blob,
+            Data& data,
+            unsigned threadCount = 0);
+
+auto readFile(const fs::path& path) -> std::vector<std::byte>;
+
+void writeFile(const fs::path& path, gsl::span<const std::byte> blob);
+}  // namespace mesh_codec
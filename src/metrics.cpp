@@ -0,0 +1,231 @@
+#include "metrics.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fmt/base.h>
+#include <fmt/format.h>
+
+namespace metrics {
+namespace {
+
+constexpr const char* kPrefix = "learn_dawn_";
+
+#if LEARN_DAWN_METRICS
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<detail::Shard>> shards;
+};
+
+// Shards outlive their threads so exited threads still show up in totals
+auto registry() -> Registry& {
+    static Registry instance;
+    return instance;
+}
+#endif
+
+auto prometheus(const Snapshot& snapshot) -> std::string {
+    std::string out;
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        const char* counter = name(static_cast<Counter>(i));
+        out += fmt::format("# TYPE {}{}_total counter\n", kPrefix, counter);
+        out += fmt::format("{}{}_total {}\n", kPrefix, counter,
+                           snapshot.counters[i]);
+    }
+    for (size_t i = 0; i < kHistogramCount; ++i) {
+        const char* histogram = name(static_cast<Histogram>(i));
+        const HistogramSnapshot& h = snapshot.histograms[i];
+        out += fmt::format("# TYPE {}{} histogram\n", kPrefix, histogram);
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b + 1 < kBucketCount; ++b) {
+            cumulative += h.buckets[b];
+            out += fmt::format("{}{}_bucket{{le=\"{}\"}} {}\n", kPrefix,
+                               histogram, bucketBoundSeconds(b), cumulative);
+        }
+        out += fmt::format("{}{}_bucket{{le=\"+Inf\"}} {}\n", kPrefix,
+                           histogram, h.count);
+        out += fmt::format("{}{}_sum {}\n", kPrefix, histogram,
+                           h.sumNanoseconds * 1e-9);
+        out += fmt::format("{}{}_count {}\n", kPrefix, histogram, h.count);
+    }
+    return out;
+}
+
+auto jsonLine(const Snapshot& snapshot) -> std::string {
+    const auto timestamp =
+        std::chrono::duration<double>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    std::string out = fmt::format("{{\"timestamp\":{:.3f},\"counters\":{{",
+                                  timestamp);
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        out += fmt::format("{}\"{}\":{}", i ? "," : "",
+                           name(static_cast<Counter>(i)),
+                           snapshot.counters[i]);
+    }
+    out += "},\"histograms\":{";
+    for (size_t i = 0; i < kHistogramCount; ++i) {
+        const HistogramSnapshot& h = snapshot.histograms[i];
+        out += fmt::format("{}\"{}\":{{\"count\":{},\"sum\":{},\"buckets\":[",
+                           i ? "," : "", name(static_cast<Histogram>(i)),
+                           h.count, h.sumNanoseconds * 1e-9);
+        for (size_t b = 0; b < kBucketCount; ++b) {
+            out += fmt::format("{}{}", b ? "," : "", h.buckets[b]);
+        }
+        out += "]}";
+    }
+    out += "}}\n";
+    return out;
+}
+
+}  // namespace
+
+auto name(Counter counter) -> const char* {
+    switch (counter) {
+        case Counter::Frames:
+            return "frames";
+        case Counter::Wakeups:
+            return "wakeups";
+        case Counter::DrawCalls:
+            return "draw_calls";
+        case Counter::Triangles:
+            return "triangles";
+        case Counter::BytesUploaded:
+            return "bytes_uploaded";
+        case Counter::WriteBufferCalls:
+            return "write_buffer_calls";
+        case Counter::SurfaceAcquireFailures:
+            return "surface_acquire_failures";
+        case Counter::DeviceErrors:
+            return "device_errors";
+        case Counter::DeviceLost:
+            return "device_lost";
+        case Counter::MapAsyncFailures:
+            return "map_async_failures";
+        case Counter::GlfwErrors:
+            return "glfw_errors";
+        default:
+            return "unknown";
+    }
+}
+
+auto name(Histogram histogram) -> const char* {
+    switch (histogram) {
+        case Histogram::LoadSeconds:
+            return "load_seconds";
+        case Histogram::RenderCpuSeconds:
+            return "render_cpu_seconds";
+        default:
+            return "unknown";
+    }
+}
+
+auto bucketBoundSeconds(size_t bucket) -> double {
+    return static_cast<double>(uint64_t{1} << bucket) * 1e-6;
+}
+
+#if LEARN_DAWN_METRICS
+namespace detail {
+auto registerShard() -> Shard* {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    return r.shards.emplace_back(std::make_unique<Shard>()).get();
+}
+}  // namespace detail
+#endif
+
+auto collect() -> Snapshot {
+    Snapshot snapshot;
+#if LEARN_DAWN_METRICS
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    constexpr auto relaxed = std::memory_order_relaxed;
+    for (const auto& shard : r.shards) {
+        for (size_t i = 0; i < kCounterCount; ++i) {
+            snapshot.counters[i] += shard->counters[i].load(relaxed);
+        }
+        for (size_t i = 0; i < kHistogramCount; ++i) {
+            HistogramSnapshot& h = snapshot.histograms[i];
+            for (size_t b = 0; b < kBucketCount; ++b) {
+                const uint64_t n = shard->buckets[i][b].load(relaxed);
+                h.buckets[b] += n;
+                h.count += n;
+            }
+            h.sumNanoseconds += shard->sums[i].load(relaxed);
+        }
+    }
+#endif
+    return snapshot;
+}
+
+Exporter::Exporter(fs::path path, Format format, double interval)
+    : path(std::move(path)),
+      format(format),
+      interval(interval),
+      enabled(LEARN_DAWN_METRICS) {}
+
+auto Exporter::fromEnvironment() -> Exporter {
+    const char* path = std::getenv("LEARN_DAWN_METRICS_PATH");
+    if (!path || !*path) {
+        return {};
+    }
+    const char* interval = std::getenv("LEARN_DAWN_METRICS_INTERVAL");
+    const double seconds = interval ? std::atof(interval) : 0.0;
+    const fs::path file(path);
+    return Exporter(file,
+                    file.extension() == ".jsonl" ? Format::JsonLines
+                                                 : Format::Prometheus,
+                    seconds > 0.0 ? seconds : 10.0);
+}
+
+void Exporter::maybeExport(double now) {
+    if (!enabled || now - lastExport < interval) {
+        return;
+    }
+    lastExport = now;
+    exportNow();
+}
+
+auto Exporter::nextExport() const -> double {
+    return enabled ? lastExport + interval
+                   : std::numeric_limits<double>::infinity();
+}
+
+void Exporter::exportNow() {
+    if (!enabled) {
+        return;
+    }
+    const Snapshot snapshot = collect();
+    bool written = false;
+    if (format == Format::JsonLines) {
+        std::ofstream file(path, std::ios::app);
+        file << jsonLine(snapshot);
+        written = static_cast<bool>(file);
+    } else {
+        // write then rename, so scrapers never see a partial file
+        fs::path tmp = path;
+        tmp += ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::trunc);
+            file << prometheus(snapshot);
+            written = static_cast<bool>(file);
+        }
+        std::error_code err;
+        fs::rename(tmp, path, err);
+        written = written && !err;
+    }
+    if (!written) {
+        fmt::println(stderr, "Failed to export metrics to {}, disabling",
+                     path.string());
+        enabled = false;
+    }
+}
+
+}  // namespace metrics
@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Off unless defined, the build sets it from ENABLE_METRICS on LearnDawnCore
+// and everything linking it. When 0 all recording calls compile out
+#ifndef LEARN_DAWN_METRICS
+#define LEARN_DAWN_METRICS 0
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * Low overhead counters and latency histograms.
+ *
+ * Every thread records into its own shard with relaxed atomics, so the hot
+ * path is a thread_local lookup and an uncontended store. Shards are only
+ * summed when a snapshot is taken, which the Exporter does periodically.
+ */
+namespace metrics {
+
+enum class Counter : size_t {
+    Frames,
+    Wakeups,
+    DrawCalls,
+    Triangles,
+    BytesUploaded,
+    WriteBufferCalls,
+    SurfaceAcquireFailures,
+    DeviceErrors,
+    DeviceLost,
+    MapAsyncFailures,
+    GlfwErrors,
+    Count,
+};
+
+enum class Histogram : size_t {
+    LoadSeconds,
+    RenderCpuSeconds,
+    Count,
+};
+
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::Count);
+constexpr size_t kHistogramCount = static_cast<size_t>(Histogram::Count);
+
+// Bucket i counts samples below 2^i microseconds, the last one is unbounded
+constexpr size_t kBucketCount = 24;
+
+struct HistogramSnapshot {
+    std::array<uint64_t, kBucketCount> buckets{};
+    uint64_t count = 0;
+    uint64_t sumNanoseconds = 0;
+};
+
+struct Snapshot {
+    std::array<uint64_t, kCounterCount> counters{};
+    std::array<HistogramSnapshot, kHistogramCount> histograms{};
+};
+
+auto name(Counter counter) -> const char*;
+
+auto name(Histogram histogram) -> const char*;
+
+auto bucketBoundSeconds(size_t bucket) -> double;
+
+// Sums all shards, including those of threads that have exited
+auto collect() -> Snapshot;
+
+#if LEARN_DAWN_METRICS
+namespace detail {
+struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, kCounterCount> counters{};
+    std::array<std::array<std::atomic<uint64_t>, kBucketCount>,
+               kHistogramCount>
+        buckets{};
+    std::array<std::atomic<uint64_t>, kHistogramCount> sums{};
+};
+
+auto registerShard() -> Shard*;
+
+inline auto localShard() -> Shard& {
+    thread_local Shard* shard = registerShard();
+    return *shard;
+}
+
+// Only the owning thread writes a shard, so no read-modify-write is needed
+inline void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount,
+                std::memory_order_relaxed);
+}
+
+inline auto bucketFor(uint64_t nanoseconds) -> size_t {
+    uint64_t micros = nanoseconds / 1000;
+    size_t bucket = 0;
+    while (micros != 0 && bucket < kBucketCount - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+}  // namespace detail
+
+inline void add(Counter counter, uint64_t amount = 1) {
+    detail::bump(
+        detail::localShard().counters[static_cast<size_t>(counter)], amount);
+}
+
+inline void observe(Histogram histogram, std::chrono::nanoseconds duration) {
+    const auto ns =
+        static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+    detail::Shard& shard = detail::localShard();
+    const auto h = static_cast<size_t>(histogram);
+    detail::bump(shard.buckets[h][detail::bucketFor(ns)], 1);
+    detail::bump(shard.sums[h], ns);
+}
+#else
+inline void add(Counter, uint64_t = 1) {}
+
+inline void observe(Histogram, std::chrono::nanoseconds) {}
+#endif
+
+// Records the lifetime of the timer into a histogram
+class ScopedTimer {
+   public:
+#if LEARN_DAWN_METRICS
+    explicit ScopedTimer(Histogram histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        observe(histogram, std::chrono::steady_clock::now() - start);
+    }
+#else
+    explicit ScopedTimer(Histogram) {}
+#endif
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    auto operator=(const ScopedTimer&) -> ScopedTimer& = delete;
+
+#if LEARN_DAWN_METRICS
+   private:
+    Histogram histogram;
+    std::chrono::steady_clock::time_point start;
+#endif
+};
+
+enum class Format {
+    Prometheus,  // text exposition format, rewritten on every export
+    JsonLines,   // one JSON object appended per export
+};
+
+/**
+ * Periodically writes a snapshot to a file. A default constructed exporter
+ * is disabled, as is one whose file can't be written.
+ */
+class Exporter {
+   public:
+    Exporter() = default;
+    Exporter(fs::path path, Format format, double interval);
+
+    /**
+     * Configured from LEARN_DAWN_METRICS_PATH, and optionally
+     * LEARN_DAWN_METRICS_INTERVAL in seconds (default 10). Paths ending in
+     * .jsonl select JSON lines, anything else the Prometheus format.
+     */
+    static auto fromEnvironment() -> Exporter;
+
+    // Exports when at least interval seconds passed since the last export
+    void maybeExport(double now);
+
+    // When maybeExport() next writes, infinity if disabled
+    auto nextExport() const -> double;
+
+    void exportNow();
+
+   private:
+    fs::path path;
+    Format format = Format::Prometheus;
+    double interval = 0.0;
+    double lastExport = 0.0;
+    bool enabled = false;
+};
+
+}  // namespace metrics
@@ -0,0 +1,32 @@
+// Converts a text mesh (see resources/data.txt) into the compressed .ldmc
+// format understood by Data::load
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "loader.hpp"
+#include "mesh_codec.hpp"
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc != 3) {
+        fmt::println(stderr, "Usage: {} <input.txt> <output{}>", argv[0],
+                     mesh_codec::kFileExtension);
+        return EXIT_FAILURE;
+    }
+    try {
+        Data data;
+        data.load(argv[1]);
+        const std::vector<std::byte> blob = mesh_codec::encode(data);
+        mesh_codec::writeFile(argv[2], blob);
+        const size_t rawSize = data.vertex.size() * sizeof(float) +
+                               data.index.size() * sizeof(uint16_t);
+        fmt::println("Packed {} vertices and {} indices: {} -> {} bytes",
+                     data.vertex.size() / kComponentsPerVertex,
+                     data.index.size(), rawSize, blob.size());
+    } catch (const std::exception& e) {
+        fmt::println(stderr, "Failed to pack mesh: {}", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}